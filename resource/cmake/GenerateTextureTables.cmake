@@ -0,0 +1,138 @@
+# ============================================================================
+#
+# Copyright (C) 2019, Jeremy Retailleau
+#
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+#
+# Generate lookup tables from SMAA textures into header files declaring
+# them and source files defining them.
+#
+# Variables defined by this module:
+#     TEXTURE_HEADERS
+#     TEXTURE_SOURCES
+#     TEXTURE_HEADER_DIR
+#
+# Cache variables used by this module:
+#     SMAA_MAX_DISTANCE
+#     SMAA_MAX_DISTANCE_DIAG
+#     SMAA_AREA_PRECISION
+#     SMAA_MAX_SEARCH_STEPS
+#     SMAA_MAX_SEARCH_STEPS_DIAG
+#
+# Usage:
+#     INCLUDE(GenerateTextureTables)
+#
+# ============================================================================
+
+set(
+    SMAA_MAX_DISTANCE 16 CACHE STRING
+    "Maximum orthogonal distance stored in the area texture."
+)
+set(
+    SMAA_MAX_DISTANCE_DIAG 20 CACHE STRING
+    "Maximum diagonal distance stored in the area texture."
+)
+set(
+    SMAA_AREA_PRECISION 8 CACHE STRING
+    "Precision of the area texture values (8, 16 or 32 bits)."
+)
+set_property(CACHE SMAA_AREA_PRECISION PROPERTY STRINGS 8 16 32)
+
+set(
+    SMAA_MAX_SEARCH_STEPS 32 CACHE STRING
+    "Maximum steps performed in horizontal and vertical pattern searches."
+)
+set(
+    SMAA_MAX_SEARCH_STEPS_DIAG 16 CACHE STRING
+    "Maximum steps performed in diagonal pattern searches."
+)
+
+# Ensure that distances found by the searches fit in the area texture, as
+# orthogonal distances are compressed quadratically.
+math(EXPR _search_DISTANCE "${SMAA_MAX_SEARCH_STEPS} * 2 + 2")
+math(EXPR _area_DISTANCE "${SMAA_MAX_DISTANCE} * ${SMAA_MAX_DISTANCE}")
+
+if(_search_DISTANCE GREATER _area_DISTANCE)
+    message(
+        FATAL_ERROR "SMAA_MAX_SEARCH_STEPS is too large for "
+        "SMAA_MAX_DISTANCE ${SMAA_MAX_DISTANCE}"
+    )
+endif()
+
+if(SMAA_MAX_SEARCH_STEPS_DIAG GREATER SMAA_MAX_DISTANCE_DIAG)
+    message(
+        FATAL_ERROR "SMAA_MAX_SEARCH_STEPS_DIAG is too large for "
+        "SMAA_MAX_DISTANCE_DIAG ${SMAA_MAX_DISTANCE_DIAG}"
+    )
+endif()
+
+add_executable(
+    texture_to_header "${CMAKE_SOURCE_DIR}/resource/tools/texture_to_header.cpp"
+)
+
+target_include_directories(
+    texture_to_header PRIVATE "${CMAKE_SOURCE_DIR}/source"
+)
+
+add_executable(
+    area_texture "${CMAKE_SOURCE_DIR}/resource/tools/area_texture.cpp"
+)
+
+set(TEXTURE_HEADERS)
+set(TEXTURE_SOURCES)
+set(TEXTURE_HEADER_DIR "${CMAKE_BINARY_DIR}/include")
+
+# Create include folder.
+file(MAKE_DIRECTORY "${TEXTURE_HEADER_DIR}")
+
+set(_search_TARGET "${TEXTURE_HEADER_DIR}/SearchTable.h")
+set(_search_SOURCE "${TEXTURE_HEADER_DIR}/SearchTable.cpp")
+
+add_custom_command(
+    OUTPUT ${_search_TARGET} ${_search_SOURCE}
+    COMMAND texture_to_header search ${_search_TARGET} ${_search_SOURCE}
+    DEPENDS texture_to_header "${CMAKE_SOURCE_DIR}/source/SearchTex.h"
+    WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
+    COMMENT "Generate SearchTable.h from SearchTex.h"
+)
+
+list(APPEND TEXTURE_HEADERS ${_search_TARGET})
+list(APPEND TEXTURE_SOURCES ${_search_SOURCE})
+
+set(_area_TARGET "${TEXTURE_HEADER_DIR}/AreaTable.h")
+set(_area_SOURCE "${TEXTURE_HEADER_DIR}/AreaTable.cpp")
+
+# Record area texture parameters so that the table is generated again when
+# they change.
+set(_area_CONFIG "${CMAKE_BINARY_DIR}/area_texture.txt")
+set(
+    _area_PARAMETERS
+    "${SMAA_MAX_DISTANCE} ${SMAA_MAX_DISTANCE_DIAG} ${SMAA_AREA_PRECISION}"
+)
+
+set(_area_PREVIOUS_PARAMETERS)
+if(EXISTS ${_area_CONFIG})
+    file(READ ${_area_CONFIG} _area_PREVIOUS_PARAMETERS)
+endif()
+
+if(NOT _area_PARAMETERS STREQUAL _area_PREVIOUS_PARAMETERS)
+    file(WRITE ${_area_CONFIG} "${_area_PARAMETERS}")
+endif()
+
+add_custom_command(
+    OUTPUT ${_area_TARGET} ${_area_SOURCE}
+    COMMAND area_texture
+        ${SMAA_MAX_DISTANCE} ${SMAA_MAX_DISTANCE_DIAG} ${SMAA_AREA_PRECISION}
+        ${_area_TARGET} ${_area_SOURCE}
+    DEPENDS area_texture ${_area_CONFIG}
+    WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
+    COMMENT "Generate AreaTable.h"
+)
+
+list(APPEND TEXTURE_HEADERS ${_area_TARGET})
+list(APPEND TEXTURE_SOURCES ${_area_SOURCE})
+
+add_custom_target(
+    texture_headers ALL DEPENDS "${TEXTURE_HEADERS}" "${TEXTURE_SOURCES}"
+)
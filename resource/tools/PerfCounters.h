@@ -0,0 +1,205 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_PERF_COUNTERS_H
+#define SMAA_PERF_COUNTERS_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * Hardware counters summed over all threads of the process.
+ *
+ * Counters are opened for the threads existing when created, so the thread
+ * pool must be created first. Events which cannot be counted on every
+ * thread, for lack of hardware support or permission, are unavailable.
+ */
+class PerfCounters
+{
+public:
+    enum Event
+    {
+        CYCLES,
+        INSTRUCTIONS,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        EVENT_COUNT
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    bool available(Event event) const { return _available[event]; }
+
+    // Return whether any event is available.
+    bool available() const;
+
+    // Read current values, scaled when counters were multiplexed. Values
+    // of unavailable events are zero.
+    void read(double values[EVENT_COUNT]) const;
+
+private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+
+    void close_event(int event);
+
+    std::vector<int> _descriptors[EVENT_COUNT];
+    bool _available[EVENT_COUNT];
+};
+
+#if defined(__linux__)
+
+// Return identifiers of all threads of the process.
+inline std::vector<int> process_threads()
+{
+    std::vector<int> threads;
+
+    DIR* directory = opendir("/proc/self/task");
+    if (!directory) {
+        return threads;
+    }
+
+    while (struct dirent* entry = readdir(directory)) {
+        if (entry->d_name[0] != '.') {
+            threads.push_back(std::atoi(entry->d_name));
+        }
+    }
+
+    closedir(directory);
+    return threads;
+}
+
+// Open counter of hardware event for thread, counting in user space only.
+inline int open_counter(unsigned long long config, int thread)
+{
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = config;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = (
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+    );
+
+    return (int) syscall(__NR_perf_event_open, &attributes, thread, -1, -1, 0);
+}
+
+inline PerfCounters::PerfCounters()
+{
+    const unsigned long long configs[EVENT_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    const std::vector<int> threads = process_threads();
+
+    for (int event = 0; event < EVENT_COUNT; event++) {
+        _available[event] = !threads.empty();
+
+        for (size_t index = 0; index < threads.size(); index++) {
+            const int descriptor = open_counter(configs[event], threads[index]);
+            if (descriptor < 0) {
+                close_event(event);
+                break;
+            }
+
+            _descriptors[event].push_back(descriptor);
+        }
+    }
+}
+
+inline PerfCounters::~PerfCounters()
+{
+    for (int event = 0; event < EVENT_COUNT; event++) {
+        close_event(event);
+    }
+}
+
+inline void PerfCounters::read(double values[EVENT_COUNT]) const
+{
+    for (int event = 0; event < EVENT_COUNT; event++) {
+        values[event] = 0.0;
+
+        for (size_t index = 0; index < _descriptors[event].size(); index++) {
+            // Value, time enabled and time running.
+            uint64_t data[3];
+            const ssize_t size = ::read(
+                _descriptors[event][index], data, sizeof(data)
+            );
+
+            if (size != (ssize_t) sizeof(data) || data[2] == 0) {
+                continue;
+            }
+
+            values[event] += (double) data[0] * data[1] / data[2];
+        }
+    }
+}
+
+inline void PerfCounters::close_event(int event)
+{
+    for (size_t index = 0; index < _descriptors[event].size(); index++) {
+        close(_descriptors[event][index]);
+    }
+
+    _descriptors[event].clear();
+    _available[event] = false;
+}
+
+#else
+
+inline PerfCounters::PerfCounters()
+{
+    for (int event = 0; event < EVENT_COUNT; event++) {
+        _available[event] = false;
+    }
+}
+
+inline PerfCounters::~PerfCounters() {}
+
+inline void PerfCounters::read(double values[EVENT_COUNT]) const
+{
+    for (int event = 0; event < EVENT_COUNT; event++) {
+        values[event] = 0.0;
+    }
+}
+
+inline void PerfCounters::close_event(int event)
+{
+    _available[event] = false;
+}
+
+#endif
+
+inline bool PerfCounters::available() const
+{
+    for (int event = 0; event < EVENT_COUNT; event++) {
+        if (_available[event]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#endif
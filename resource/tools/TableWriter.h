@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_TABLE_WRITER_H
+#define SMAA_TABLE_WRITER_H
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+inline std::string format_define(const std::string& name, int value)
+{
+    std::ostringstream stream;
+    stream << "#define " << name << " " << value << "\n";
+    return stream.str();
+}
+
+// Format declaration of table defined in generated source file.
+inline std::string format_declaration(
+    const std::string& type, const std::string& name
+)
+{
+    return "extern const " + type + " " + name + "[];\n";
+}
+
+inline std::string format_table(
+    const std::string& name, const std::vector<float>& table
+)
+{
+    std::ostringstream stream;
+    stream.precision(9);
+
+    stream << "const float " << name << "[] = {";
+    for (size_t index = 0; index < table.size(); index++) {
+        if (index % 8 == 0) {
+            stream << "\n   ";
+        }
+        stream << " " << std::showpoint << table[index] << "f,";
+    }
+    stream << "\n};\n\n";
+
+    return stream.str();
+}
+
+// Format integer table, with values converted by the conversion function.
+template<typename Converter>
+inline std::string format_integer_table(
+    const std::string& type, const std::string& name,
+    const std::vector<float>& table, Converter convert
+)
+{
+    std::ostringstream stream;
+    stream << std::hex;
+
+    stream << "const " << type << " " << name << "[] = {";
+    for (size_t index = 0; index < table.size(); index++) {
+        if (index % 12 == 0) {
+            stream << "\n   ";
+        }
+        stream << " 0x" << (unsigned int) convert(table[index]) << ",";
+    }
+    stream << "\n};\n\n";
+
+    return stream.str();
+}
+
+inline bool write_file(
+    const std::string& output_file, const std::string& output
+)
+{
+    std::ofstream output_stream(output_file.c_str());
+    if (!output_stream.is_open()) {
+        std::cerr << "Impossible to write output file." << std::endl;
+        return false;
+    }
+
+    output_stream << output;
+    output_stream.close();
+    return true;
+}
+
+// Write header content guarded by conditional variable.
+inline bool write_header(
+    const std::string& output_file, const std::string& var,
+    const std::string& content
+)
+{
+    std::string output;
+    output += "#ifndef " + var + "\n";
+    output += "#define " + var + "\n\n";
+    output += content;
+    output += "#endif // " + var;
+
+    return write_file(output_file, output);
+}
+
+// Write source file defining tables declared by header, so that tables are
+// only compiled once.
+inline bool write_source(
+    const std::string& output_file, const std::string& header_file,
+    const std::string& content
+)
+{
+    const size_t separator = header_file.find_last_of("/\\");
+    const std::string header_name = (
+        separator == std::string::npos ?
+            header_file : header_file.substr(separator + 1)
+    );
+
+    std::string output;
+    output += "#include \"" + header_name + "\"\n\n";
+    output += content;
+
+    return write_file(output_file, output);
+}
+
+#endif // SMAA_TABLE_WRITER_H
@@ -0,0 +1,521 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ * Adapted from:
+ *
+ * Jorge Jimenez et al. (2013). Enhanced Subpixel Morphological Antialiasing.
+ * http://www.iryoku.com/smaa/
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TableWriter.h"
+
+// Subsample offsets for orthogonal and diagonal areas.
+const double SUBSAMPLE_OFFSETS_ORTHO[] = {
+    0.0, -0.25, 0.25, -0.125, 0.125, -0.375, 0.375
+};
+const double SUBSAMPLE_OFFSETS_DIAG[][2] = {
+    {0.0, 0.0}, {0.25, -0.25}, {-0.25, 0.25}, {0.125, -0.125}, {-0.125, 0.125}
+};
+
+const int SUBSAMPLES_ORTHO = 7;
+const int SUBSAMPLES_DIAG = 5;
+
+// Number of samples for calculating areas in the diagonal textures.
+// Diagonal areas are calculated using brute force sampling.
+const int SAMPLES_DIAG = 30;
+
+// Maximum distance for smoothing u-shapes.
+const double SMOOTH_MAX_DISTANCE = 32.0;
+
+// Mapping tables for placing each pattern subtexture into its place.
+const int EDGES_ORTHO[16][2] = {
+    {0, 0}, {3, 0}, {0, 3}, {3, 3}, {1, 0}, {4, 0}, {1, 3}, {4, 3},
+    {0, 1}, {3, 1}, {0, 4}, {3, 4}, {1, 1}, {4, 1}, {1, 4}, {4, 4}
+};
+const int EDGES_DIAG[16][2] = {
+    {0, 0}, {1, 0}, {0, 2}, {1, 2}, {2, 0}, {3, 0}, {2, 2}, {3, 2},
+    {0, 1}, {1, 1}, {0, 3}, {1, 3}, {2, 1}, {3, 1}, {2, 3}, {3, 3}
+};
+
+
+struct Point
+{
+    Point(double x_, double y_) : x(x_), y(y_) {}
+
+    Point operator+(const Point& other) const {
+        return Point(x + other.x, y + other.y);
+    }
+
+    bool operator!=(const Point& other) const {
+        return x != other.x || y != other.y;
+    }
+
+    double x;
+    double y;
+};
+
+struct Area
+{
+    Area(double a1_ = 0.0, double a2_ = 0.0) : a1(a1_), a2(a2_) {}
+
+    Area operator+(const Area& other) const {
+        return Area(a1 + other.a1, a2 + other.a2);
+    }
+
+    Area operator/(double value) const {
+        return Area(a1 / value, a2 / value);
+    }
+
+    double a1;
+    double a2;
+};
+
+
+double saturate(double value)
+{
+    return value < 0.0 ? 0.0 : (value > 1.0 ? 1.0 : value);
+}
+
+double lerp(double a, double b, double p)
+{
+    return a + (b - a) * p;
+}
+
+// Smoothing function for small u-patterns.
+Area smooth_area(double d, const Area& a1, const Area& a2)
+{
+    const Area b1(std::sqrt(a1.a1 * 2.0) * 0.5, std::sqrt(a1.a2 * 2.0) * 0.5);
+    const Area b2(std::sqrt(a2.a1 * 2.0) * 0.5, std::sqrt(a2.a2 * 2.0) * 0.5);
+    const double p = saturate(d / SMOOTH_MAX_DISTANCE);
+
+    return (
+        Area(lerp(b1.a1, a1.a1, p), lerp(b1.a2, a1.a2, p))
+        + Area(lerp(b2.a1, a2.a1, p), lerp(b2.a2, a2.a2, p))
+    );
+}
+
+// Calculates the area under the line p1->p2, for the pixel x..x+1.
+Area area_ortho_line(const Point& p1, const Point& p2, double x)
+{
+    const Point d(p2.x - p1.x, p2.y - p1.y);
+    const double x1 = x;
+    const double x2 = x + 1.0;
+    const double y1 = p1.y + d.y * (x1 - p1.x) / d.x;
+    const double y2 = p1.y + d.y * (x2 - p1.x) / d.x;
+
+    const bool inside = (
+        (x1 >= p1.x && x1 < p2.x) || (x2 > p1.x && x2 <= p2.x)
+    );
+    if (!inside) {
+        return Area();
+    }
+
+    const bool is_trapezoid = (
+        std::copysign(1.0, y1) == std::copysign(1.0, y2)
+        || std::fabs(y1) < 1e-4 || std::fabs(y2) < 1e-4
+    );
+
+    if (is_trapezoid) {
+        const double a = (y1 + y2) / 2.0;
+        return a < 0.0 ? Area(std::fabs(a), 0.0) : Area(0.0, std::fabs(a));
+    }
+
+    // Then, we got two triangles.
+    double integral;
+    const double xc = -p1.y * d.x / d.y + p1.x;
+    const double fraction = std::modf(xc, &integral);
+    const double a1 = xc > p1.x ? y1 * fraction / 2.0 : 0.0;
+    const double a2 = xc < p2.x ? y2 * (1.0 - fraction) / 2.0 : 0.0;
+    const double a = std::fabs(a1) > std::fabs(a2) ? a1 : -a2;
+
+    return (
+        a < 0.0 ?
+        Area(std::fabs(a1), std::fabs(a2)) :
+        Area(std::fabs(a2), std::fabs(a1))
+    );
+}
+
+// Calculates the area for a given pattern and distances to the left and to
+// the right, biased by an offset.
+Area area_ortho(int pattern, double left, double right, double offset)
+{
+    const double d = left + right + 1.0;
+
+    const double o1 = 0.5 + offset;
+    const double o2 = 0.5 + offset - 1.0;
+
+    switch (pattern) {
+        case 1:
+            // We only offset L patterns in the crossing edge side, to make it
+            // converge with the unfiltered pattern 0.
+            if (left <= right) {
+                return area_ortho_line(
+                    Point(0.0, o2), Point(d / 2.0, 0.0), left
+                );
+            }
+            return Area();
+
+        case 2:
+            if (left >= right) {
+                return area_ortho_line(
+                    Point(d / 2.0, 0.0), Point(d, o2), left
+                );
+            }
+            return Area();
+
+        case 3:
+            return smooth_area(
+                d,
+                area_ortho_line(Point(0.0, o2), Point(d / 2.0, 0.0), left),
+                area_ortho_line(Point(d / 2.0, 0.0), Point(d, o2), left)
+            );
+
+        case 4:
+            if (left <= right) {
+                return area_ortho_line(
+                    Point(0.0, o1), Point(d / 2.0, 0.0), left
+                );
+            }
+            return Area();
+
+        case 6:
+            // To avoid discontinuities between Z and L patterns, the full
+            // offsetted Z revectorization is blended with partially
+            // offsetted L patterns.
+            if (std::fabs(offset) > 0.0) {
+                const Area a1 = area_ortho_line(
+                    Point(0.0, o1), Point(d, o2), left
+                );
+                const Area a2 = (
+                    area_ortho_line(Point(0.0, o1), Point(d / 2.0, 0.0), left)
+                    + area_ortho_line(Point(d / 2.0, 0.0), Point(d, o2), left)
+                );
+                return (a1 + a2) / 2.0;
+            }
+            return area_ortho_line(Point(0.0, o1), Point(d, o2), left);
+
+        case 7:
+            return area_ortho_line(Point(0.0, o1), Point(d, o2), left);
+
+        case 8:
+            if (left >= right) {
+                return area_ortho_line(
+                    Point(d / 2.0, 0.0), Point(d, o1), left
+                );
+            }
+            return Area();
+
+        case 9:
+            if (std::fabs(offset) > 0.0) {
+                const Area a1 = area_ortho_line(
+                    Point(0.0, o2), Point(d, o1), left
+                );
+                const Area a2 = (
+                    area_ortho_line(Point(0.0, o2), Point(d / 2.0, 0.0), left)
+                    + area_ortho_line(Point(d / 2.0, 0.0), Point(d, o1), left)
+                );
+                return (a1 + a2) / 2.0;
+            }
+            return area_ortho_line(Point(0.0, o2), Point(d, o1), left);
+
+        case 11:
+            return area_ortho_line(Point(0.0, o2), Point(d, o1), left);
+
+        case 12:
+            return smooth_area(
+                d,
+                area_ortho_line(Point(0.0, o1), Point(d / 2.0, 0.0), left),
+                area_ortho_line(Point(d / 2.0, 0.0), Point(d, o1), left)
+            );
+
+        case 13:
+            return area_ortho_line(Point(0.0, o2), Point(d, o1), left);
+
+        case 14:
+            return area_ortho_line(Point(0.0, o1), Point(d, o2), left);
+
+        default:
+            // Patterns 0, 5, 10 and 15 are not filtered.
+            return Area();
+    }
+}
+
+// Calculates the area under the line p1->p2 for the pixel p using brute
+// force sampling.
+double area_diag_pixel(const Point& p1, const Point& p2, const Point& p)
+{
+    if (!(p1 != p2)) {
+        return 1.0;
+    }
+
+    const double xm = (p1.x + p2.x) / 2.0;
+    const double ym = (p1.y + p2.y) / 2.0;
+    const double a = p2.y - p1.y;
+    const double b = p1.x - p2.x;
+
+    int count = 0;
+    for (int x = 0; x < SAMPLES_DIAG; x++) {
+        for (int y = 0; y < SAMPLES_DIAG; y++) {
+            const double sx = p.x + (double) x / (SAMPLES_DIAG - 1);
+            const double sy = p.y + (double) y / (SAMPLES_DIAG - 1);
+            if (a * (sx - xm) + b * (sy - ym) > 0.0) {
+                count++;
+            }
+        }
+    }
+
+    return (double) count / (SAMPLES_DIAG * SAMPLES_DIAG);
+}
+
+// Calculates the area under the line p1->p2, including the pixel and its
+// opposite.
+Area area_diag_line(
+    int pattern, Point p1, Point p2, double left, const double* offset
+)
+{
+    const Point shift(offset[0], offset[1]);
+    if (EDGES_DIAG[pattern][0] > 0) {
+        p1 = p1 + shift;
+    }
+    if (EDGES_DIAG[pattern][1] > 0) {
+        p2 = p2 + shift;
+    }
+
+    const double a1 = area_diag_pixel(p1, p2, Point(1.0 + left, left));
+    const double a2 = area_diag_pixel(p1, p2, Point(1.0 + left, 1.0 + left));
+    return Area(1.0 - a1, a2);
+}
+
+// Calculates the area for a given pattern and distances to the left and to
+// the right, biased by an offset.
+Area area_diag(int pattern, double left, double right, const double* offset)
+{
+    const Point d(left + right + 1.0, left + right + 1.0);
+
+    // Unlike orthogonal patterns, the ends of the diagonal patterns are not
+    // known, so a blend of both possibilities is computed. Each pattern is
+    // described by the start and end points of both possible lines.
+    static const double POINTS[16][4][2] = {
+        {{1, 1}, {1, 1}, {1, 0}, {1, 0}},
+        {{1, 0}, {0, 0}, {1, 0}, {1, 0}},
+        {{0, 0}, {1, 0}, {1, 0}, {1, 0}},
+        {{1, 0}, {1, 0}, {1, 0}, {1, 0}},
+        {{1, 1}, {0, 0}, {1, 1}, {1, 0}},
+        {{1, 1}, {0, 0}, {1, 0}, {1, 0}},
+        {{1, 1}, {1, 0}, {1, 1}, {1, 0}},
+        {{1, 1}, {1, 0}, {1, 0}, {1, 0}},
+        {{0, 0}, {1, 1}, {1, 0}, {1, 1}},
+        {{1, 0}, {1, 1}, {1, 0}, {1, 1}},
+        {{0, 0}, {1, 1}, {1, 0}, {1, 0}},
+        {{1, 0}, {1, 1}, {1, 0}, {1, 0}},
+        {{1, 1}, {1, 1}, {1, 1}, {1, 1}},
+        {{1, 1}, {1, 1}, {1, 0}, {1, 1}},
+        {{1, 1}, {1, 0}, {1, 1}, {1, 1}},
+        {{1, 1}, {1, 1}, {1, 0}, {1, 0}},
+    };
+
+    const double (*points)[2] = POINTS[pattern];
+
+    const Area a1 = area_diag_line(
+        pattern,
+        Point(points[0][0], points[0][1]),
+        Point(points[1][0], points[1][1]) + d,
+        left, offset
+    );
+    const Area a2 = area_diag_line(
+        pattern,
+        Point(points[2][0], points[2][1]),
+        Point(points[3][0], points[3][1]) + d,
+        left, offset
+    );
+
+    return (a1 + a2) / 2.0;
+}
+
+// Quantize normalized value according to precision.
+float quantize(double value, int precision)
+{
+    if (precision == 8) {
+        return (float) ((int) (value * 255.0)) / 255.0f;
+    }
+    else if (precision == 16) {
+        return (float) ((int) (value * 65535.0)) / 65535.0f;
+    }
+
+    return (float) value;
+}
+
+unsigned char to_unsigned_char(float value)
+{
+    return (unsigned char) std::floor(value * 255.0f + 0.5f);
+}
+
+unsigned short to_unsigned_short(float value)
+{
+    return (unsigned short) std::floor(value * 65535.0f + 0.5f);
+}
+
+// Compute the whole area texture, with orthogonal areas on the left and
+// diagonal areas on the right, and one row of subtextures per subsample
+// offset.
+void compute_area_table(
+    std::vector<float>& table, int width, int height,
+    int distance, int distance_diag, int precision
+)
+{
+    table.assign(width * height * 2, 0.0f);
+
+    const int subtexture_height = height / SUBSAMPLES_ORTHO;
+    const int diag_start = distance * 5;
+
+    for (int index = 0; index < SUBSAMPLES_ORTHO; index++) {
+        const double offset = SUBSAMPLE_OFFSETS_ORTHO[index];
+
+        for (int pattern = 0; pattern < 16; pattern++) {
+            for (int left = 0; left < distance; left++) {
+                for (int right = 0; right < distance; right++) {
+                    // Distances are compressed quadratically.
+                    const Area area = area_ortho(
+                        pattern, left * left, right * right, offset
+                    );
+
+                    const int x = distance * EDGES_ORTHO[pattern][0] + left;
+                    const int y = (
+                        subtexture_height * index
+                        + distance * EDGES_ORTHO[pattern][1] + right
+                    );
+
+                    float* pixel = &table[(y * width + x) * 2];
+                    pixel[0] = quantize(area.a1, precision);
+                    pixel[1] = quantize(area.a2, precision);
+                }
+            }
+        }
+    }
+
+    for (int index = 0; index < SUBSAMPLES_DIAG; index++) {
+        const double* offset = SUBSAMPLE_OFFSETS_DIAG[index];
+
+        for (int pattern = 0; pattern < 16; pattern++) {
+            for (int left = 0; left < distance_diag; left++) {
+                for (int right = 0; right < distance_diag; right++) {
+                    const Area area = area_diag(pattern, left, right, offset);
+
+                    const int x = (
+                        diag_start
+                        + distance_diag * EDGES_DIAG[pattern][0] + left
+                    );
+                    const int y = (
+                        subtexture_height * index
+                        + distance_diag * EDGES_DIAG[pattern][1] + right
+                    );
+
+                    float* pixel = &table[(y * width + x) * 2];
+                    pixel[0] = quantize(area.a1, precision);
+                    pixel[1] = quantize(area.a2, precision);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char** args)
+{
+    if (argc != 6) {
+        std::cerr << "area_texture: syntax error" << std::endl;
+        std::cerr << "usage: area_texture max_distance max_distance_diag "
+                  << "precision AreaTable.h AreaTable.cpp" << std::endl;
+        std::cerr << "example: area_texture 16 20 8 AreaTable.h AreaTable.cpp"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Extract arguments.
+    const int distance = std::atoi(args[1]);
+    const int distance_diag = std::atoi(args[2]);
+    const int precision = std::atoi(args[3]);
+    std::string output_file(args[4]);
+    std::string source_file(args[5]);
+
+    if (distance < 1 || distance_diag < 1) {
+        std::cerr << "Distances must be positive." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (precision != 8 && precision != 16 && precision != 32) {
+        std::cerr << "Precision must be 8, 16 or 32." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Each subtexture holds 5 orthogonal and 4 diagonal crossing edges
+    // values for each distance.
+    const int width = distance * 5 + distance_diag * 4;
+    const int height = (
+        std::max(distance * 5, distance_diag * 4) * SUBSAMPLES_ORTHO
+    );
+
+    std::vector<float> table;
+    compute_area_table(
+        table, width, height, distance, distance_diag, precision
+    );
+
+    // Compute output, declaring tables in header and defining them in
+    // source file, so that they are only compiled once.
+    std::string output;
+    output += format_define("AREATABLE_WIDTH", width);
+    output += format_define("AREATABLE_HEIGHT", height);
+    output += format_define("AREATABLE_CHANNELS", 2);
+    output += format_define("AREATABLE_MAX_DISTANCE", distance);
+    output += format_define("AREATABLE_MAX_DISTANCE_DIAG", distance_diag);
+    output += format_define("AREATABLE_PRECISION", precision);
+    output += "\n";
+    output += "// Normalized values.\n";
+    output += format_declaration("float", "areaTable");
+    output += "\n";
+    output += "// Values stored with requested precision.\n";
+
+    std::string source;
+    source += format_table("areaTable", table);
+
+    if (precision == 8) {
+        output += "typedef unsigned char AreaTableType;\n\n";
+        output += format_declaration("AreaTableType", "areaTableData");
+        source += format_integer_table(
+            "AreaTableType", "areaTableData", table, to_unsigned_char
+        );
+    }
+    else if (precision == 16) {
+        output += "typedef unsigned short AreaTableType;\n\n";
+        output += format_declaration("AreaTableType", "areaTableData");
+        source += format_integer_table(
+            "AreaTableType", "areaTableData", table, to_unsigned_short
+        );
+    }
+    else {
+        output += "typedef float AreaTableType;\n\n";
+        output += "static const AreaTableType* const areaTableData = ";
+        output += "areaTable;\n";
+    }
+    output += "\n";
+
+    // Extract header and source files.
+    if (!write_header(output_file, "AREATABLE_H", output)) {
+        return EXIT_FAILURE;
+    }
+
+    if (!write_source(source_file, output_file, source)) {
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
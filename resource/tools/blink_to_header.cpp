@@ -6,6 +6,7 @@
  */
 
 #include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -27,7 +28,7 @@ int main(int argc, char** args)
     if (argc != 3) {
         std::cerr << "blink_to_header: syntax error" << std::endl;
         std::cerr << "usage: blink_to_header foo.blk foo.h" << std::endl;
-        exit(0x0);
+        return EXIT_FAILURE;
     }
 
     // Extract arguments.
@@ -62,7 +63,7 @@ int main(int argc, char** args)
     }
     else {
         std::cerr << "Impossible to read input file." << std::endl;
-        exit(0x0);
+        return EXIT_FAILURE;
     }
 
     output += "#endif // " + var;
@@ -76,7 +77,7 @@ int main(int argc, char** args)
     }
     else {
         std::cerr << "Impossible to write output file." << std::endl;
-        exit(0x0);
+        return EXIT_FAILURE;
     }
 
     return 0;
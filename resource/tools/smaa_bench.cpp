@@ -0,0 +1,501 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Autotune.h"
+#include "BatchPipeline.h"
+#include "PerfCounters.h"
+#include "SceneGenerator.h"
+
+
+struct Options
+{
+    Options()
+        : width(1920), height(1080), frames(8), threads(0)
+        , tile_width(256), tile_height(256), frames_in_flight(2), repeat(3)
+        , autotune(false), pin(false), counters(false), planar(false)
+        , type(Nuke::PIXEL_FLOAT)
+        , weight_precision(Nuke::NativePipeline::WEIGHTS_UNORM8)
+    {}
+
+    int width;
+    int height;
+    int frames;
+    int threads;
+    int tile_width;
+    int tile_height;
+    int frames_in_flight;
+    int repeat;
+    bool autotune;
+    bool pin;
+    bool counters;
+    bool planar;
+    Nuke::PixelType type;
+    Nuke::NativePipeline::WeightPrecision weight_precision;
+
+    // Scene of first frame, following frames using the next seeds.
+    Nuke::SceneParameters scene;
+};
+
+// Time and hardware counters accumulated over runs of one stage.
+struct PassProfile
+{
+    PassProfile() : milliseconds(0.0), pixels(0.0)
+    {
+        for (int event = 0; event < PerfCounters::EVENT_COUNT; event++) {
+            values[event] = 0.0;
+        }
+    }
+
+    // Accumulate run of stage, from counter values before and after it.
+    void add(
+        double run_milliseconds, double run_pixels,
+        const double* start_values, const double* end_values
+    )
+    {
+        milliseconds += run_milliseconds;
+        pixels += run_pixels;
+
+        for (int event = 0; event < PerfCounters::EVENT_COUNT; event++) {
+            values[event] += end_values[event] - start_values[event];
+        }
+    }
+
+    double milliseconds;
+    double pixels;
+    double values[PerfCounters::EVENT_COUNT];
+};
+
+
+void print_usage()
+{
+    std::cerr << "usage: smaa_bench [--width 1920] [--height 1080] "
+              << "[--frames 8] [--threads 0] [--tile 256x256] "
+              << "[--in-flight 2] [--repeat 3] [--autotune] [--pin] "
+              << "[--counters] [--seed 1] [--polygons 12] [--lines 24] "
+              << "[--text 6] [--patches 2] [--diagonal 0.75] "
+              << "[--type float] [--planar] [--weights 8]" << std::endl;
+    std::cerr << "  --autotune: tune tile size and threads for the host, "
+              << "store them in the tuning file and use them" << std::endl;
+    std::cerr << "  --pin: pin threads to cores ordered by NUMA node and "
+              << "keep each tile on the same thread" << std::endl;
+    std::cerr << "  --counters: report time and hardware counters per pass"
+              << std::endl;
+    std::cerr << "  --seed, --polygons, --lines, --text, --patches, "
+              << "--diagonal: geometry of synthetic frames" << std::endl;
+    std::cerr << "  --type: pixel type of frames, among uint8, uint16, "
+              << "half and float" << std::endl;
+    std::cerr << "  --planar: store frames as one plane per channel instead "
+              << "of interleaved" << std::endl;
+    std::cerr << "  --weights: bits of each stored blending weight, among "
+              << "8, 16 and 32 (float)" << std::endl;
+}
+
+// Parse pixel type from its name.
+bool parse_pixel_type(const std::string& name, Nuke::PixelType& type)
+{
+    if (name == "uint8") {
+        type = Nuke::PIXEL_UINT8;
+    }
+    else if (name == "uint16") {
+        type = Nuke::PIXEL_UINT16;
+    }
+    else if (name == "half") {
+        type = Nuke::PIXEL_HALF;
+    }
+    else if (name == "float") {
+        type = Nuke::PIXEL_FLOAT;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_options(int argc, char** args, Options& options)
+{
+    for (int index = 1; index < argc; index++) {
+        const std::string name(args[index]);
+
+        if (name == "--autotune") {
+            options.autotune = true;
+            continue;
+        }
+
+        if (name == "--pin") {
+            options.pin = true;
+            continue;
+        }
+
+        if (name == "--counters") {
+            options.counters = true;
+            continue;
+        }
+
+        if (name == "--planar") {
+            options.planar = true;
+            continue;
+        }
+
+        if (index + 1 >= argc) {
+            return false;
+        }
+        const char* value = args[++index];
+
+        if (name == "--width") {
+            options.width = std::atoi(value);
+        }
+        else if (name == "--height") {
+            options.height = std::atoi(value);
+        }
+        else if (name == "--frames") {
+            options.frames = std::atoi(value);
+        }
+        else if (name == "--threads") {
+            options.threads = std::atoi(value);
+        }
+        else if (name == "--tile") {
+            char* end;
+            options.tile_width = (int) std::strtol(value, &end, 10);
+            options.tile_height = *end == 'x' ? std::atoi(end + 1) : 0;
+        }
+        else if (name == "--in-flight") {
+            options.frames_in_flight = std::atoi(value);
+        }
+        else if (name == "--repeat") {
+            options.repeat = std::atoi(value);
+        }
+        else if (name == "--seed") {
+            options.scene.seed = (unsigned int) std::strtoul(value, 0, 10);
+        }
+        else if (name == "--polygons") {
+            options.scene.polygons = std::atoi(value);
+        }
+        else if (name == "--lines") {
+            options.scene.lines = std::atoi(value);
+        }
+        else if (name == "--text") {
+            options.scene.text = std::atoi(value);
+        }
+        else if (name == "--patches") {
+            options.scene.texture_patches = std::atoi(value);
+        }
+        else if (name == "--diagonal") {
+            options.scene.diagonal_ratio = (float) std::atof(value);
+        }
+        else if (name == "--type") {
+            if (!parse_pixel_type(value, options.type)) {
+                return false;
+            }
+        }
+        else if (name == "--weights") {
+            const int bits = std::atoi(value);
+            if (bits == 8) {
+                options.weight_precision = (
+                    Nuke::NativePipeline::WEIGHTS_UNORM8
+                );
+            }
+            else if (bits == 16) {
+                options.weight_precision = (
+                    Nuke::NativePipeline::WEIGHTS_UNORM16
+                );
+            }
+            else if (bits == 32) {
+                options.weight_precision = Nuke::NativePipeline::WEIGHTS_FLOAT;
+            }
+            else {
+                return false;
+            }
+        }
+        else {
+            return false;
+        }
+    }
+
+    return (
+        options.width > 0 && options.height > 0 && options.frames > 0
+        && options.tile_width > 0 && options.tile_height > 0
+        && options.repeat > 0
+    );
+}
+
+// Return bytes of one pixel component of type.
+size_t component_size(Nuke::PixelType type)
+{
+    switch (type) {
+        case Nuke::PIXEL_UINT8:
+            return 1;
+        case Nuke::PIXEL_UINT16:
+        case Nuke::PIXEL_HALF:
+            return 2;
+        case Nuke::PIXEL_FLOAT:
+            return 4;
+    }
+    return 4;
+}
+
+// Return view of RGBA frame stored in data as components of type T,
+// either interleaved or as one plane per channel.
+template<typename T>
+Nuke::OutputView typed_frame_view(
+    unsigned char* data, int width, int height, bool planar
+)
+{
+    T* pixels = reinterpret_cast<T*>(data);
+    if (planar) {
+        return Nuke::OutputView(
+            pixels, width, height, 4, 1, width, (std::ptrdiff_t) width * height
+        );
+    }
+    return Nuke::OutputView(pixels, width, height, 4, 4, width * 4);
+}
+
+Nuke::OutputView frame_view(unsigned char* data, const Options& options)
+{
+    const int width = options.width;
+    const int height = options.height;
+
+    switch (options.type) {
+        case Nuke::PIXEL_UINT8:
+            return typed_frame_view<uint8_t>(
+                data, width, height, options.planar
+            );
+        case Nuke::PIXEL_UINT16:
+            return typed_frame_view<uint16_t>(
+                data, width, height, options.planar
+            );
+        case Nuke::PIXEL_HALF:
+            return typed_frame_view<Nuke::Half>(
+                data, width, height, options.planar
+            );
+        case Nuke::PIXEL_FLOAT:
+            break;
+    }
+    return typed_frame_view<float>(data, width, height, options.planar);
+}
+
+// Print counter value per pixel, or n/a when unavailable.
+void print_per_pixel(
+    const PerfCounters& counters, const PassProfile& pass,
+    PerfCounters::Event event, int width
+)
+{
+    std::cout << std::setw(width);
+    if (!counters.available(event) || pass.pixels == 0.0) {
+        std::cout << "n/a";
+        return;
+    }
+    std::cout << pass.values[event] / pass.pixels;
+}
+
+void print_passes(
+    const std::vector<PassProfile>& passes, const PerfCounters& counters,
+    int width, int height
+)
+{
+    if (!counters.available()) {
+        std::cout << "Hardware counters unavailable, only reporting time "
+                  << "(see /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+    }
+
+    std::cout << std::left << std::setw(20) << "pass" << std::right
+              << std::setw(10) << "ms/frame" << std::setw(8) << "IPC"
+              << std::setw(12) << "cycles/px" << std::setw(16)
+              << "LLC misses/px" << std::setw(18) << "branch misses/px"
+              << std::endl;
+
+    std::cout << std::fixed;
+
+    for (size_t stage = 0; stage < passes.size(); stage++) {
+        const PassProfile& pass = passes[stage];
+        const double frames = pass.pixels / ((double) width * height);
+
+        std::cout << std::left << std::setw(20)
+                  << Nuke::NativePipeline::stage_name(
+                      (Nuke::NativePipeline::Stage) stage
+                  )
+                  << std::right << std::setprecision(3) << std::setw(10)
+                  << (frames > 0.0 ? pass.milliseconds / frames : 0.0);
+
+        std::cout << std::setprecision(2) << std::setw(8);
+        if (
+            counters.available(PerfCounters::CYCLES)
+            && counters.available(PerfCounters::INSTRUCTIONS)
+            && pass.values[PerfCounters::CYCLES] > 0.0
+        ) {
+            std::cout << (
+                pass.values[PerfCounters::INSTRUCTIONS]
+                / pass.values[PerfCounters::CYCLES]
+            );
+        }
+        else {
+            std::cout << "n/a";
+        }
+
+        std::cout << std::setprecision(2);
+        print_per_pixel(counters, pass, PerfCounters::CYCLES, 12);
+
+        std::cout << std::setprecision(4);
+        print_per_pixel(counters, pass, PerfCounters::LLC_MISSES, 16);
+        print_per_pixel(counters, pass, PerfCounters::BRANCH_MISSES, 18);
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char** args)
+{
+    Options options;
+    if (!parse_options(argc, args, options)) {
+        std::cerr << "smaa_bench: syntax error" << std::endl;
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    const int width = options.width;
+    const int height = options.height;
+
+    const size_t frame_size = (
+        (size_t) width * height * 4 * component_size(options.type)
+    );
+
+    std::vector<std::vector<unsigned char> > inputs(options.frames);
+    std::vector<std::vector<unsigned char> > outputs(options.frames);
+    std::vector<Nuke::BatchFrame> frames;
+
+    for (int index = 0; index < options.frames; index++) {
+        inputs[index].resize(frame_size);
+        outputs[index].resize(frame_size);
+
+        const Nuke::OutputView input = frame_view(&inputs[index][0], options);
+
+        Nuke::SceneParameters scene = options.scene;
+        scene.seed += index;
+        Nuke::generate_scene(scene, input);
+
+        frames.push_back(
+            Nuke::BatchFrame(
+                input,
+                frame_view(&outputs[index][0], options)
+            )
+        );
+    }
+
+    const Nuke::EdgeStatistics statistics = Nuke::measure_edges(
+        frames[0].input
+    );
+
+    std::cout << "First frame edges: " << statistics.density() * 100.0
+              << "% of pixels, mean run " << statistics.mean_horizontal_run()
+              << " (horizontal) " << statistics.mean_vertical_run()
+              << " (vertical), " << statistics.short_run_ratio() * 100.0
+              << "% short runs" << std::endl;
+
+    Nuke::ThreadPool pool(options.threads, options.pin);
+
+    if (options.autotune) {
+        const Nuke::TuningConfig config = Nuke::autotune(pool);
+        const std::string path = Nuke::tuning_file_path();
+
+        if (!Nuke::save_tuning(path, config)) {
+            std::cerr << "Impossible to write tuning file: " << path
+                      << std::endl;
+        }
+
+        std::cout << "Tuned tile " << config.tile_width << "x"
+                  << config.tile_height << ", " << config.threads
+                  << " threads (" << path << ")" << std::endl;
+
+        options.tile_width = config.tile_width;
+        options.tile_height = config.tile_height;
+        options.threads = config.threads;
+    }
+
+    Nuke::BatchPipeline pipeline(pool, options.frames_in_flight);
+    pipeline.set_tile_size(options.tile_width, options.tile_height);
+    pipeline.set_weight_precision(options.weight_precision);
+    pipeline.set_threads(options.threads);
+
+    // First batch allocates intermediates.
+    pipeline.process(frames);
+
+    // Counters are opened once the pool threads exist.
+    std::unique_ptr<PerfCounters> counters;
+    std::vector<PassProfile> passes(Nuke::NativePipeline::STAGE_COUNT);
+
+    std::chrono::steady_clock::time_point stage_start;
+    double stage_values[PerfCounters::EVENT_COUNT];
+
+    if (options.counters) {
+        counters.reset(new PerfCounters());
+
+        pipeline.set_stage_observer(
+            [&](Nuke::NativePipeline::Stage stage, int count, bool done) {
+                double values[PerfCounters::EVENT_COUNT];
+
+                if (!done) {
+                    counters->read(stage_values);
+                    stage_start = std::chrono::steady_clock::now();
+                    return;
+                }
+
+                const std::chrono::duration<double, std::milli> duration = (
+                    std::chrono::steady_clock::now() - stage_start
+                );
+                counters->read(values);
+
+                passes[stage].add(
+                    duration.count(), (double) count * width * height,
+                    stage_values, values
+                );
+            }
+        );
+    }
+
+    double best = 0.0;
+    for (int index = 0; index < options.repeat; index++) {
+        const std::chrono::steady_clock::time_point start = (
+            std::chrono::steady_clock::now()
+        );
+
+        pipeline.process(frames);
+
+        const std::chrono::duration<double, std::milli> duration = (
+            std::chrono::steady_clock::now() - start
+        );
+
+        if (index == 0 || duration.count() < best) {
+            best = duration.count();
+        }
+    }
+
+    const int threads = options.threads > 0 ? options.threads : pool.size();
+
+    std::cout << width << "x" << height << ", " << options.frames
+              << " frames, " << threads << " threads, tile "
+              << options.tile_width << "x" << options.tile_height
+              << (pool.pinned() ? ", pinned" : "") << ": "
+              << best / options.frames << " ms per frame" << std::endl;
+
+    std::cout << "Intermediates of " << options.frames_in_flight
+              << " frames in flight: "
+              << pipeline.memory_usage() / (1024.0 * 1024.0) << " MB"
+              << std::endl;
+
+    if (counters) {
+        print_passes(passes, *counters, width, height);
+    }
+
+    return 0;
+}
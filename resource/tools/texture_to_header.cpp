@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "SearchTex.h"
+#include "TableWriter.h"
+
+// Size of the search texture used to compute texture coordinates.
+const float SEARCH_SIZE_X = 66.0f;
+const float SEARCH_SIZE_Y = 33.0f;
+
+// Bilinear fetches performed by the searches return multiples of 1/32.
+const int EDGE_LEVELS = 32;
+
+// Size of the search table: one column per edge value and search side, and
+// one row per crossing edge value.
+const int SEARCHTABLE_WIDTH = (EDGE_LEVELS + 1) * 2;
+const int SEARCHTABLE_HEIGHT = EDGE_LEVELS + 1;
+
+
+float fetch_search_texture(int x, int y)
+{
+    // Emulate edge clamped access.
+    x = std::min(std::max(x, 0), SEARCHTEX_WIDTH - 1);
+    y = std::min(std::max(y, 0), SEARCHTEX_HEIGHT - 1);
+    return (float) searchTexBytes[y * SEARCHTEX_PITCH + x];
+}
+
+float search_length(float e1, float e2, float offset)
+{
+    // Same texture coordinates as computed by the SMAABlend kernel.
+    float scale_x = SEARCH_SIZE_X * 0.5f - 1.0f;
+    float scale_y = SEARCH_SIZE_Y * -1.0f + 1.0f;
+    float bias_x = SEARCH_SIZE_X * offset + 0.5f;
+    float bias_y = SEARCH_SIZE_Y * 1.0f - 0.5f;
+
+    float x = scale_x * e1 + bias_x;
+    float y = scale_y * e2 + bias_y;
+
+    // Coordinates fall on texel centres, so a single texel is read, as a
+    // GPU sampling the texture with the same coordinates would.
+    const float value = fetch_search_texture(
+        (int) std::floor(x), (int) std::floor(y)
+    );
+
+    return value / 255.0f;
+}
+
+void compute_search_table(std::vector<float>& table)
+{
+    table.resize(SEARCHTABLE_WIDTH * SEARCHTABLE_HEIGHT);
+
+    for (int y = 0; y < SEARCHTABLE_HEIGHT; y++) {
+        for (int x = 0; x < SEARCHTABLE_WIDTH; x++) {
+            const int side = x / (EDGE_LEVELS + 1);
+            const float e1 = (float) (x % (EDGE_LEVELS + 1)) / EDGE_LEVELS;
+            const float e2 = (float) y / EDGE_LEVELS;
+
+            table[y * SEARCHTABLE_WIDTH + x] = search_length(
+                e1, e2, side * 0.5f
+            );
+        }
+    }
+}
+
+int main(int argc, char** args)
+{
+    if (argc != 4) {
+        std::cerr << "texture_to_header: syntax error" << std::endl;
+        std::cerr << "usage: texture_to_header search SearchTable.h "
+                  << "SearchTable.cpp" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Extract arguments.
+    std::string table_name(args[1]);
+    std::string output_file(args[2]);
+    std::string source_file(args[3]);
+
+    if (table_name != "search") {
+        std::cerr << "Unknown table: " << table_name << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<float> table;
+    compute_search_table(table);
+
+    // Compute output, declaring table in header and defining it in source
+    // file, so that it is only compiled once.
+    std::string output;
+    output += format_define("SEARCHTABLE_WIDTH", SEARCHTABLE_WIDTH);
+    output += format_define("SEARCHTABLE_HEIGHT", SEARCHTABLE_HEIGHT);
+    output += format_define("SEARCHTABLE_CHANNELS", 1);
+    output += "\n";
+    output += "// Normalized values.\n";
+    output += format_declaration("float", "searchTable");
+    output += "\n";
+
+    // Extract header and source files.
+    if (!write_header(output_file, "SEARCHTABLE_H", output)) {
+        return EXIT_FAILURE;
+    }
+
+    if (!write_source(
+        source_file, output_file, format_table("searchTable", table)
+    )) {
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
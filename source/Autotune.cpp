@@ -0,0 +1,241 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Autotune.h"
+#include "BatchPipeline.h"
+#include "SceneGenerator.h"
+
+
+namespace {
+
+// Candidate tile sizes.
+const int TILE_SIZES[][2] = {
+    {64, 64}, {128, 64}, {128, 128}, {256, 128}, {256, 256}, {512, 256},
+    {512, 512}
+};
+const int TILE_SIZE_COUNT = sizeof(TILE_SIZES) / sizeof(TILE_SIZES[0]);
+
+// Number of frames of the synthetic workload, and timed runs per
+// configuration.
+const int FRAMES = 2;
+const int RUNS = 2;
+
+// Return candidate numbers of threads: powers of two below pool size, and
+// pool size itself.
+std::vector<int> thread_candidates(int pool_size)
+{
+    std::vector<int> candidates;
+    for (int threads = 1; threads < pool_size; threads *= 2) {
+        candidates.push_back(threads);
+    }
+    candidates.push_back(pool_size);
+    return candidates;
+}
+
+std::string host_name()
+{
+#if defined(_WIN32)
+    const char* name = std::getenv("COMPUTERNAME");
+    return name ? std::string(name) : std::string("localhost");
+#else
+    char name[256] = {0};
+    if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == 0) {
+        return "localhost";
+    }
+    return std::string(name);
+#endif
+}
+
+std::string home_directory()
+{
+#if defined(_WIN32)
+    const char* home = std::getenv("USERPROFILE");
+#else
+    const char* home = std::getenv("HOME");
+#endif
+    return home ? std::string(home) : std::string(".");
+}
+
+void make_directory(const std::string& path)
+{
+#if defined(_WIN32)
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+} // namespace
+
+
+namespace Nuke {
+
+TuningConfig autotune(ThreadPool& pool, int width, int height)
+{
+    std::vector<std::vector<float> > inputs(FRAMES);
+    std::vector<std::vector<float> > outputs(FRAMES);
+    std::vector<BatchFrame> frames;
+
+    for (int index = 0; index < FRAMES; index++) {
+        inputs[index].resize(width * height * 4);
+        outputs[index].resize(width * height * 4);
+
+        // Default scenes, differing from one frame to the next.
+        SceneParameters scene;
+        scene.seed = index + 1;
+        generate_scene(
+            scene,
+            OutputView(&inputs[index][0], width, height, 4, 4, width * 4)
+        );
+
+        frames.push_back(
+            BatchFrame(
+                InputView(&inputs[index][0], width, height, 4, 4, width * 4),
+                OutputView(&outputs[index][0], width, height, 4, 4, width * 4)
+            )
+        );
+    }
+
+    const std::vector<int> threads = thread_candidates(pool.size());
+
+    TuningConfig best_config;
+    double best_duration = -1.0;
+
+    for (size_t candidate = 0; candidate < threads.size(); candidate++) {
+        for (int tile_index = 0; tile_index < TILE_SIZE_COUNT; tile_index++) {
+            BatchPipeline pipeline(pool, FRAMES);
+            pipeline.set_threads(threads[candidate]);
+            pipeline.set_tile_size(
+                TILE_SIZES[tile_index][0], TILE_SIZES[tile_index][1]
+            );
+
+            // First batch allocates intermediates.
+            pipeline.process(frames);
+
+            for (int run = 0; run < RUNS; run++) {
+                const std::chrono::steady_clock::time_point start = (
+                    std::chrono::steady_clock::now()
+                );
+
+                pipeline.process(frames);
+
+                const std::chrono::duration<double> duration = (
+                    std::chrono::steady_clock::now() - start
+                );
+
+                if (best_duration < 0.0 || duration.count() < best_duration) {
+                    best_duration = duration.count();
+                    best_config.tile_width = TILE_SIZES[tile_index][0];
+                    best_config.tile_height = TILE_SIZES[tile_index][1];
+                    best_config.threads = threads[candidate];
+                }
+            }
+        }
+    }
+
+    return best_config;
+}
+
+std::string tuning_file_path()
+{
+    const char* path = std::getenv("SMAA_TUNING_FILE");
+    if (path && path[0] != 0) {
+        return std::string(path);
+    }
+
+    return home_directory() + "/.smaa/tuning-" + host_name() + ".cfg";
+}
+
+bool load_tuning(const std::string& path, TuningConfig& config)
+{
+    std::ifstream stream(path.c_str());
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    TuningConfig result;
+    int found = 0;
+
+    std::string line;
+    while (std::getline(stream, line)) {
+        const size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            continue;
+        }
+
+        const std::string key = line.substr(0, separator);
+        const int value = std::atoi(line.c_str() + separator + 1);
+
+        if (key == "tile_width" && value > 0) {
+            result.tile_width = value;
+            found++;
+        }
+        else if (key == "tile_height" && value > 0) {
+            result.tile_height = value;
+            found++;
+        }
+        else if (key == "threads" && value >= 0) {
+            result.threads = value;
+            found++;
+        }
+    }
+
+    if (found != 3) {
+        return false;
+    }
+
+    config = result;
+    return true;
+}
+
+bool save_tuning(const std::string& path, const TuningConfig& config)
+{
+    const size_t separator = path.find_last_of("/\\");
+    if (separator != std::string::npos) {
+        make_directory(path.substr(0, separator));
+    }
+
+    std::ofstream stream(path.c_str());
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    stream << "tile_width=" << config.tile_width << "\n";
+    stream << "tile_height=" << config.tile_height << "\n";
+    stream << "threads=" << config.threads << "\n";
+    return stream.good();
+}
+
+TuningConfig host_tuning()
+{
+    static std::mutex mutex;
+    static bool ready = false;
+    static TuningConfig config;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ready) {
+        load_tuning(tuning_file_path(), config);
+        ready = true;
+    }
+
+    return config;
+}
+
+} // namespace Nuke
@@ -0,0 +1,57 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_AUTOTUNE_H
+#define SMAA_NUKE_AUTOTUNE_H
+
+#include <string>
+
+#include "ThreadPool.h"
+
+
+namespace Nuke {
+
+/**
+ * Tile size and number of threads used by the native pipeline.
+ */
+struct TuningConfig
+{
+    TuningConfig()
+        : tile_width(256), tile_height(256), threads(0)
+    {}
+
+    int tile_width;
+    int tile_height;
+
+    // Number of threads, or all threads of the pool when zero.
+    int threads;
+};
+
+// Benchmark candidate configurations on synthetic frames processed on
+// pool, and return the fastest one.
+TuningConfig autotune(ThreadPool& pool, int width = 1024, int height = 576);
+
+// Return path of the tuning file of the host, which can be overridden with
+// the SMAA_TUNING_FILE environment variable.
+std::string tuning_file_path();
+
+// Read configuration from file. Return whether it succeeded.
+bool load_tuning(const std::string& path, TuningConfig& config);
+
+// Write configuration to file, creating its directory if needed. Return
+// whether it succeeded.
+bool save_tuning(const std::string& path, const TuningConfig& config);
+
+// Return configuration of the host, read from the tuning file once, or
+// default configuration if there is none. The candidates are only swept by
+// autotune, which is too slow to run while rendering, so the file is
+// written by `smaa_bench --autotune`.
+TuningConfig host_tuning();
+
+} // namespace Nuke
+
+#endif
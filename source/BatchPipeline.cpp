@@ -0,0 +1,268 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+
+#include "BatchPipeline.h"
+
+
+namespace {
+
+// Part of a tile of a frame in flight scheduled for the blending weight
+// stages.
+struct WeightTask
+{
+    int frame;
+    int index;
+    float cost;
+};
+
+// Schedule blending weights of frames in flight, and gather parts of tiles
+// of all frames from the most to the least expensive.
+void schedule_weights(
+    std::vector<Nuke::NativePipeline>& pipelines, int count, int workers,
+    std::vector<WeightTask>& tasks
+)
+{
+    tasks.clear();
+
+    for (int frame = 0; frame < count; frame++) {
+        pipelines[frame].schedule_weights(workers);
+
+        const std::vector<Nuke::ScheduledTile>& schedule = (
+            pipelines[frame].weight_schedule()
+        );
+
+        for (int index = 0; index < (int) schedule.size(); index++) {
+            const WeightTask task = {frame, index, schedule[index].cost};
+            tasks.push_back(task);
+        }
+    }
+
+    std::stable_sort(
+        tasks.begin(), tasks.end(),
+        [](const WeightTask& first, const WeightTask& second) {
+            return first.cost > second.cost;
+        }
+    );
+}
+
+// Return whether output of frame matches the size and components of its
+// input.
+bool valid_frame(const Nuke::BatchFrame& frame)
+{
+    return (
+        frame.input.width > 0 && frame.input.height > 0
+        && frame.output.width == frame.input.width
+        && frame.output.height == frame.input.height
+        && frame.output.components == frame.input.components
+    );
+}
+
+// Return whether frames have the same size and components.
+bool same_format(const Nuke::BatchFrame& first, const Nuke::BatchFrame& second)
+{
+    return (
+        first.input.width == second.input.width
+        && first.input.height == second.input.height
+        && first.input.components == second.input.components
+    );
+}
+
+} // namespace
+
+
+namespace Nuke {
+
+BatchPipeline::BatchPipeline(ThreadPool& pool, int frames_in_flight)
+    : _pool(pool)
+    , _frames_in_flight(std::max(frames_in_flight, 1))
+    , _tile_width(256)
+    , _tile_height(256)
+    , _threads(0)
+    , _tile_affinity(pool.pinned())
+    , _weight_precision(NativePipeline::WEIGHTS_FLOAT)
+{
+}
+
+void BatchPipeline::set_tile_size(int width, int height)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tile_width = width;
+    _tile_height = height;
+}
+
+void BatchPipeline::set_threads(int threads)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _threads = threads;
+}
+
+void BatchPipeline::set_tile_affinity(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tile_affinity = enabled;
+}
+
+void BatchPipeline::set_weight_precision(
+    NativePipeline::WeightPrecision precision
+)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _weight_precision = precision;
+}
+
+void BatchPipeline::set_stage_observer(const StageObserver& observer)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stage_observer = observer;
+}
+
+size_t BatchPipeline::memory_usage()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t bytes = 0;
+    for (size_t index = 0; index < _pipelines.size(); index++) {
+        bytes += _pipelines[index].memory_usage();
+    }
+    return bytes;
+}
+
+void BatchPipeline::process(const std::vector<BatchFrame>& frames)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<BatchFrame> remaining;
+    for (size_t index = 0; index < frames.size(); index++) {
+        if (valid_frame(frames[index])) {
+            remaining.push_back(frames[index]);
+        }
+    }
+
+    // Intermediates are sized for a single format, so frames are processed
+    // in batches of frames sharing the format of the first one left.
+    while (!remaining.empty()) {
+        std::vector<BatchFrame> batch;
+        std::vector<BatchFrame> others;
+
+        for (size_t index = 0; index < remaining.size(); index++) {
+            if (same_format(remaining[0], remaining[index])) {
+                batch.push_back(remaining[index]);
+            }
+            else {
+                others.push_back(remaining[index]);
+            }
+        }
+
+        process_batch(batch);
+        remaining.swap(others);
+    }
+}
+
+void BatchPipeline::process_batch(const std::vector<BatchFrame>& frames)
+{
+    const int width = frames[0].input.width;
+    const int height = frames[0].input.height;
+
+    const int group_size = std::min((int) frames.size(), _frames_in_flight);
+    if ((int) _pipelines.size() < group_size) {
+        _pipelines.resize(group_size);
+    }
+
+    for (int index = 0; index < group_size; index++) {
+        _pipelines[index].set_weight_precision(_weight_precision);
+        _pipelines[index].resize(width, height, _tile_width, _tile_height);
+    }
+
+    const int tile_count = (int) _pipelines[0].tiles().size();
+
+    const ThreadPool::Schedule schedule = (
+        _tile_affinity ? ThreadPool::STATIC : ThreadPool::DYNAMIC
+    );
+
+    const int workers = (
+        _threads > 0 ? std::min(_threads, _pool.size()) : _pool.size()
+    );
+
+    std::vector<WeightTask> weight_tasks;
+
+    for (size_t first = 0; first < frames.size(); first += group_size) {
+        const int count = std::min(
+            group_size, (int) (frames.size() - first)
+        );
+
+        for (int stage = 0; stage < NativePipeline::STAGE_COUNT; stage++) {
+            if (_stage_observer) {
+                _stage_observer((NativePipeline::Stage) stage, count, false);
+            }
+
+            // Without tile affinity, blending weights are computed on parts
+            // of tiles balanced on their cost, the most expensive of all
+            // frames first.
+            const bool balanced = !_tile_affinity && (
+                stage == NativePipeline::HORIZONTAL_WEIGHTS
+                || stage == NativePipeline::VERTICAL_WEIGHTS
+            );
+
+            if (balanced && stage == NativePipeline::HORIZONTAL_WEIGHTS) {
+                schedule_weights(_pipelines, count, workers, weight_tasks);
+            }
+
+            if (balanced) {
+                _pool.run(
+                    (int) weight_tasks.size(),
+                    [&](int task, int) {
+                        const WeightTask& weight_task = weight_tasks[task];
+                        NativePipeline& pipeline = (
+                            _pipelines[weight_task.frame]
+                        );
+                        const BatchFrame& batch_frame = (
+                            frames[first + weight_task.frame]
+                        );
+
+                        pipeline.run_stage(
+                            (NativePipeline::Stage) stage,
+                            pipeline.weight_schedule()[weight_task.index].tile,
+                            batch_frame.input, batch_frame.output
+                        );
+                    },
+                    _threads, ThreadPool::DYNAMIC
+                );
+            }
+            else {
+                // Consecutive tasks alternate between frames, so that a
+                // static schedule assigns the same tiles of each frame to a
+                // worker.
+                _pool.run(
+                    count * tile_count,
+                    [&](int task, int) {
+                        const int frame = task % count;
+                        const BatchFrame& batch_frame = frames[first + frame];
+
+                        _pipelines[frame].run_stage(
+                            (NativePipeline::Stage) stage, task / count,
+                            batch_frame.input, batch_frame.output
+                        );
+                    },
+                    _threads, schedule
+                );
+            }
+
+            if (_stage_observer) {
+                _stage_observer((NativePipeline::Stage) stage, count, true);
+            }
+        }
+    }
+}
+
+void BatchPipeline::process(const InputView& input, const OutputView& output)
+{
+    process(std::vector<BatchFrame>(1, BatchFrame(input, output)));
+}
+
+} // namespace Nuke
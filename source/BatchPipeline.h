@@ -0,0 +1,128 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_BATCH_PIPELINE_H
+#define SMAA_NUKE_BATCH_PIPELINE_H
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "NativePipeline.h"
+#include "ThreadPool.h"
+
+
+namespace Nuke {
+
+/**
+ * Input and output of one frame processed in a batch.
+ */
+struct BatchFrame
+{
+    BatchFrame() {}
+    BatchFrame(const InputView& input, const OutputView& output)
+        : input(input), output(output)
+    {}
+
+    InputView input;
+    OutputView output;
+};
+
+/**
+ * Native pipeline applied on several frames of the same format.
+ *
+ * Intermediates of each frame in flight are kept from one batch to the
+ * next, and tiles of all frames in flight are interleaved across the
+ * workers of the thread pool, so that workers done with a stage of one
+ * frame can carry on with another frame.
+ *
+ * With tile affinity, each tile is assigned to the same worker for all
+ * stages and batches, so that its intermediates are first touched, and
+ * then read, from the same NUMA node when the pool is pinned.
+ */
+class BatchPipeline
+{
+public:
+    // Called on the calling thread before and after a stage is run on a
+    // number of frames.
+    typedef std::function<
+        void(NativePipeline::Stage stage, int frames, bool done)
+    > StageObserver;
+
+    // Create batch processing on pool, with a number of frames processed
+    // at the same time.
+    explicit BatchPipeline(
+        ThreadPool& pool = ThreadPool::shared(), int frames_in_flight = 2
+    );
+
+    ThreadPool& pool() const { return _pool; }
+
+    // Set size of tiles processed by each task.
+    void set_tile_size(int width, int height);
+
+    int tile_width() const { return _tile_width; }
+    int tile_height() const { return _tile_height; }
+
+    // Set number of workers of the pool used, or all of them when zero.
+    void set_threads(int threads);
+
+    int threads() const { return _threads; }
+
+    // Set whether tiles are statically assigned to workers instead of being
+    // taken by whichever worker is available. Enabled by default when the
+    // pool is pinned.
+    void set_tile_affinity(bool enabled);
+
+    bool tile_affinity() const { return _tile_affinity; }
+
+    // Set storage of blending weights of frames in flight.
+    void set_weight_precision(NativePipeline::WeightPrecision precision);
+
+    NativePipeline::WeightPrecision weight_precision() const {
+        return _weight_precision;
+    }
+
+    // Set function notified around each stage, to profile stages.
+    void set_stage_observer(const StageObserver& observer);
+
+    // Return bytes allocated for intermediates of frames in flight, which
+    // are kept from one batch to the next.
+    size_t memory_usage();
+
+    // Apply SMAA on frames, in batches of frames with the same size and
+    // number of components. Frames whose output does not match the size
+    // and components of their input are skipped. Concurrent calls are
+    // processed one after the other.
+    void process(const std::vector<BatchFrame>& frames);
+
+    // Apply SMAA on a single frame.
+    void process(const InputView& input, const OutputView& output);
+
+private:
+    BatchPipeline(const BatchPipeline&);
+    BatchPipeline& operator=(const BatchPipeline&);
+
+    // Apply SMAA on frames with the same size and number of components,
+    // with lock held.
+    void process_batch(const std::vector<BatchFrame>& frames);
+
+    ThreadPool& _pool;
+    int _frames_in_flight;
+    int _tile_width;
+    int _tile_height;
+    int _threads;
+    bool _tile_affinity;
+    NativePipeline::WeightPrecision _weight_precision;
+    StageObserver _stage_observer;
+
+    std::vector<NativePipeline> _pipelines;
+    std::mutex _mutex;
+};
+
+} // namespace Nuke
+
+#endif
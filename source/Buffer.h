@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_BUFFER_H
+#define SMAA_NUKE_BUFFER_H
+
+#include <cstddef>
+
+
+namespace Nuke {
+
+/**
+ * Array whose values are left uninitialized when allocated.
+ *
+ * Pages of large allocations are only mapped when first written, so that
+ * on NUMA systems they are placed on the node of the thread which writes
+ * them first rather than the one which allocated them.
+ */
+template<typename T>
+class Buffer
+{
+public:
+    Buffer() : _data(0), _size(0) {}
+    ~Buffer() { delete[] _data; }
+
+    Buffer(Buffer&& other) noexcept
+        : _data(other._data), _size(other._size)
+    {
+        other._data = 0;
+        other._size = 0;
+    }
+
+    Buffer& operator=(Buffer&& other) noexcept
+    {
+        if (this != &other) {
+            delete[] _data;
+            _data = other._data;
+            _size = other._size;
+            other._data = 0;
+            other._size = 0;
+        }
+        return *this;
+    }
+
+    // Reallocate buffer when size changes, leaving values uninitialized.
+    void resize(size_t size)
+    {
+        if (size == _size) {
+            return;
+        }
+
+        delete[] _data;
+        _data = size ? new T[size] : 0;
+        _size = size;
+    }
+
+    size_t size() const { return _size; }
+
+    T* data() { return _data; }
+    const T* data() const { return _data; }
+
+    T& operator[](size_t index) { return _data[index]; }
+    const T& operator[](size_t index) const { return _data[index]; }
+
+private:
+    Buffer(const Buffer&);
+    Buffer& operator=(const Buffer&);
+
+    T* _data;
+    size_t _size;
+};
+
+} // namespace Nuke
+
+#endif
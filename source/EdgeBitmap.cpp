@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+
+#include "EdgeBitmap.h"
+
+
+namespace Nuke {
+
+EdgeBitmap::EdgeBitmap()
+    : _width(0)
+    , _height(0)
+    , _row_words(0)
+    , _column_words(0)
+{
+}
+
+void EdgeBitmap::resize(int width, int height)
+{
+    _width = width;
+    _height = height;
+    _row_words = (width + 63) / 64;
+    _column_words = (height + 63) / 64;
+
+    _left_rows.resize(_row_words * height);
+    _top_rows.resize(_row_words * height);
+    _left_columns.resize(_column_words * width);
+    _top_columns.resize(_column_words * width);
+}
+
+size_t EdgeBitmap::memory_usage() const
+{
+    return (
+        _left_rows.size() + _top_rows.size() + _left_columns.size()
+        + _top_columns.size()
+    ) * sizeof(uint64_t);
+}
+
+void EdgeBitmap::set_row_words(int y, int index, uint64_t left, uint64_t top)
+{
+    _left_rows[y * _row_words + index] = left;
+    _top_rows[y * _row_words + index] = top;
+}
+
+void EdgeBitmap::update_columns()
+{
+    update_columns(0, 0, _width, _height);
+}
+
+void EdgeBitmap::update_columns(int x0, int y0, int x1, int y1)
+{
+    for (int block_y = y0 / 64; block_y < (y1 + 63) / 64; block_y++) {
+        for (int block_x = x0 / 64; block_x < (x1 + 63) / 64; block_x++) {
+            transpose_rows(_left_rows, _left_columns, block_x, block_y);
+            transpose_rows(_top_rows, _top_columns, block_x, block_y);
+        }
+    }
+}
+
+void EdgeBitmap::transpose_rows(
+    const Buffer<uint64_t>& rows, Buffer<uint64_t>& columns,
+    int block_x, int block_y
+)
+{
+    const int x0 = block_x * 64;
+    const int y0 = block_y * 64;
+    const int block_width = std::min(_width - x0, 64);
+    const int block_height = std::min(_height - y0, 64);
+
+    uint64_t block[64];
+    bool empty = true;
+
+    for (int y = 0; y < 64; y++) {
+        block[y] = 0;
+        if (y < block_height) {
+            block[y] = rows[(y0 + y) * _row_words + block_x];
+        }
+        empty = empty && !block[y];
+    }
+
+    if (!empty) {
+        transpose_bits(block);
+    }
+
+    for (int x = 0; x < block_width; x++) {
+        columns[(x0 + x) * _column_words + block_y] = block[x];
+    }
+}
+
+} // namespace Nuke
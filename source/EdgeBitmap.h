@@ -0,0 +1,192 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_EDGE_BITMAP_H
+#define SMAA_NUKE_EDGE_BITMAP_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "Buffer.h"
+
+
+namespace Nuke {
+
+// Index of lowest bit set in non-zero word.
+inline int lowest_bit(uint64_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int) index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Index of highest bit set in non-zero word.
+inline int highest_bit(uint64_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return (int) index;
+#else
+    return 63 - __builtin_clzll(word);
+#endif
+}
+
+// Number of bits set in word.
+inline int bit_count(uint64_t word)
+{
+#if defined(_MSC_VER)
+    return (int) __popcnt64(word);
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+// Keep bits of word below index, with index in [0, 64].
+inline uint64_t low_bits(uint64_t word, int index)
+{
+#if defined(__BMI2__)
+    return _bzhi_u64(word, (unsigned int) index);
+#else
+    return index >= 64 ? word : word & ((uint64_t(1) << index) - 1);
+#endif
+}
+
+// Transpose block of 64x64 bits in place, so that bit x of word y is moved
+// to bit y of word x.
+inline void transpose_bits(uint64_t* block)
+{
+    uint64_t mask = 0x00000000ffffffffULL;
+
+    // Swap off-diagonal quadrants of increasingly smaller sub-blocks.
+    for (int size = 32; size != 0; size >>= 1, mask ^= mask << size) {
+        for (int k = 0; k < 64; k = ((k | size) + 1) & ~size) {
+            const uint64_t swap = ((block[k] >> size) ^ block[k | size]) & mask;
+            block[k] ^= swap << size;
+            block[k | size] ^= swap;
+        }
+    }
+}
+
+/**
+ * Horizontal and vertical edges stored as 64-pixel bitmasks.
+ *
+ * Left edges (red channel of the edges texture) and top edges (green channel
+ * of the edges texture) are stored per row, and copied per column so that
+ * vertical searches can scan contiguous words too.
+ */
+class EdgeBitmap
+{
+public:
+    EdgeBitmap();
+
+    // Resize bitmap. Edges are undefined until rows are set, so that each
+    // word is first touched by the thread setting it.
+    void resize(int width, int height);
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+
+    int row_words() const { return _row_words; }
+    int column_words() const { return _column_words; }
+
+    // Return bytes allocated for row and column bitmasks.
+    size_t memory_usage() const;
+
+    // Store edges of 64 consecutive pixels of row, from word index.
+    void set_row_words(int y, int index, uint64_t left, uint64_t top);
+
+    // Copy row bitmasks to column bitmasks, transposing blocks of 64x64
+    // pixels.
+    void update_columns();
+
+    // Copy row bitmasks of region aligned on 64 pixels to column bitmasks.
+    void update_columns(int x0, int y0, int x1, int y1);
+
+    uint64_t* left_row(int y) { return &_left_rows[y * _row_words]; }
+    uint64_t* top_row(int y) { return &_top_rows[y * _row_words]; }
+
+    const uint64_t* left_row(int y) const {
+        return &_left_rows[y * _row_words];
+    }
+    const uint64_t* top_row(int y) const {
+        return &_top_rows[y * _row_words];
+    }
+
+    const uint64_t* left_column(int x) const {
+        return &_left_columns[x * _column_words];
+    }
+    const uint64_t* top_column(int x) const {
+        return &_top_columns[x * _column_words];
+    }
+
+    // Return edges of pixel, with position clamped to bitmap.
+    int left(int x, int y) const { return bit(_left_rows, x, y); }
+    int top(int x, int y) const { return bit(_top_rows, x, y); }
+
+    // Return edges of pixel from column bitmasks, with position clamped to
+    // bitmap.
+    int column_left(int x, int y) const {
+        return column_bit(_left_columns, x, y);
+    }
+    int column_top(int x, int y) const {
+        return column_bit(_top_columns, x, y);
+    }
+
+private:
+    int bit(const Buffer<uint64_t>& rows, int x, int y) const;
+    int column_bit(const Buffer<uint64_t>& columns, int x, int y) const;
+
+    void transpose_rows(
+        const Buffer<uint64_t>& rows, Buffer<uint64_t>& columns,
+        int block_x, int block_y
+    );
+
+    int _width;
+    int _height;
+    int _row_words;
+    int _column_words;
+
+    Buffer<uint64_t> _left_rows;
+    Buffer<uint64_t> _top_rows;
+    Buffer<uint64_t> _left_columns;
+    Buffer<uint64_t> _top_columns;
+};
+
+inline int EdgeBitmap::bit(
+    const Buffer<uint64_t>& rows, int x, int y
+) const
+{
+    x = x < 0 ? 0 : (x >= _width ? _width - 1 : x);
+    y = y < 0 ? 0 : (y >= _height ? _height - 1 : y);
+    return (int) ((rows[y * _row_words + (x >> 6)] >> (x & 63)) & 1);
+}
+
+inline int EdgeBitmap::column_bit(
+    const Buffer<uint64_t>& columns, int x, int y
+) const
+{
+    x = x < 0 ? 0 : (x >= _width ? _width - 1 : x);
+    y = y < 0 ? 0 : (y >= _height ? _height - 1 : y);
+    return (int) ((columns[x * _column_words + (y >> 6)] >> (y & 63)) & 1);
+}
+
+} // namespace Nuke
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_HALF_H
+#define SMAA_NUKE_HALF_H
+
+#include <stdint.h>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+
+namespace Nuke {
+
+// Convert half float bits to float.
+inline float half_to_float(uint16_t bits)
+{
+#if defined(__F16C__)
+    return _cvtsh_ss(bits);
+#else
+    const uint32_t sign = (uint32_t) (bits & 0x8000) << 16;
+    uint32_t exponent = (bits >> 10) & 0x1f;
+    uint32_t mantissa = bits & 0x3ff;
+
+    uint32_t result;
+    if (exponent == 0x1f) {
+        // Infinity, or quiet NaN keeping its payload.
+        result = sign | 0x7f800000 | (mantissa << 13);
+        if (mantissa) {
+            result |= 0x400000;
+        }
+    }
+    else if (exponent != 0) {
+        result = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0) {
+        result = sign;
+    }
+    else {
+        // Normalize subnormal value.
+        exponent = 113;
+        while (!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        result = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &result, sizeof(value));
+    return value;
+#endif
+}
+
+// Convert float to half float bits, rounding to nearest even.
+inline uint16_t float_to_half(float value)
+{
+#if defined(__F16C__)
+    return _cvtss_sh(value, 0);
+#else
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint16_t sign = (uint16_t) ((bits >> 16) & 0x8000);
+    const uint32_t absolute = bits & 0x7fffffff;
+
+    // Infinity, or quiet NaN keeping the top bits of its payload.
+    if (absolute > 0x7f800000) {
+        return sign | 0x7e00 | ((absolute >> 13) & 0x3ff);
+    }
+    if (absolute == 0x7f800000) {
+        return sign | 0x7c00;
+    }
+
+    // Overflow to infinity.
+    if (absolute >= 0x477ff000) {
+        return sign | 0x7c00;
+    }
+
+    // Subnormal or zero.
+    if (absolute < 0x38800000) {
+        if (absolute < 0x33000000) {
+            return sign;
+        }
+
+        const uint32_t exponent = absolute >> 23;
+        const uint32_t mantissa = (absolute & 0x7fffff) | 0x800000;
+        const int shift = 126 - (int) exponent;
+
+        const uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t middle = 1u << (shift - 1);
+
+        const bool round_up = (
+            remainder > middle || (remainder == middle && (half & 1))
+        );
+        return sign | (uint16_t) (half + round_up);
+    }
+
+    const uint32_t half = (absolute - 0x38000000) >> 13;
+    const uint32_t remainder = absolute & 0x1fff;
+
+    const bool round_up = (
+        remainder > 0x1000 || (remainder == 0x1000 && (half & 1))
+    );
+    return sign | (uint16_t) (half + round_up);
+#endif
+}
+
+/**
+ * Half float pixel value, stored as its 16 bits.
+ */
+struct Half
+{
+    Half() : bits(0) {}
+    explicit Half(float value) : bits(float_to_half(value)) {}
+
+    operator float() const { return half_to_float(bits); }
+
+    uint16_t bits;
+};
+
+} // namespace Nuke
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "MemoryCounter.h"
+
+
+namespace Nuke {
+
+MemoryCounter::MemoryCounter(MemoryCounter* parent)
+    : _parent(parent)
+    , _current(0)
+    , _peak(0)
+{
+}
+
+void MemoryCounter::add(long long bytes)
+{
+    const long long current = _current.fetch_add(bytes) + bytes;
+
+    long long peak = _peak.load();
+    while (current > peak && !_peak.compare_exchange_weak(peak, current)) {
+    }
+
+    if (_parent) {
+        _parent->add(bytes);
+    }
+}
+
+void MemoryCounter::reset_peak()
+{
+    _peak.store(_current.load());
+}
+
+} // namespace Nuke
@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_MEMORY_COUNTER_H
+#define SMAA_NUKE_MEMORY_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+
+
+namespace Nuke {
+
+/**
+ * Bytes currently allocated and their peak, updated from any thread.
+ *
+ * Allocations are also added to the parent counter, so that a counter per
+ * stripe can contribute to the counter of the whole frame.
+ */
+class MemoryCounter
+{
+public:
+    explicit MemoryCounter(MemoryCounter* parent = 0);
+
+    // Add allocated bytes, or released bytes when negative.
+    void add(long long bytes);
+
+    long long current() const { return _current.load(); }
+    long long peak() const { return _peak.load(); }
+
+    // Restart peak from bytes currently allocated.
+    void reset_peak();
+
+private:
+    MemoryCounter(const MemoryCounter&);
+    MemoryCounter& operator=(const MemoryCounter&);
+
+    MemoryCounter* _parent;
+    std::atomic<long long> _current;
+    std::atomic<long long> _peak;
+};
+
+/**
+ * Bytes accounted on counter for the lifetime of the scope.
+ */
+class MemoryAllocation
+{
+public:
+    MemoryAllocation(MemoryCounter& counter, long long bytes)
+        : _counter(counter), _bytes(bytes)
+    {
+        _counter.add(_bytes);
+    }
+
+    ~MemoryAllocation() { _counter.add(-_bytes); }
+
+private:
+    MemoryAllocation(const MemoryAllocation&);
+    MemoryAllocation& operator=(const MemoryAllocation&);
+
+    MemoryCounter& _counter;
+    long long _bytes;
+};
+
+} // namespace Nuke
+
+#endif
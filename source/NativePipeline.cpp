@@ -0,0 +1,1529 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ * Adapted from:
+ *
+ * Jorge Jimenez et al. (2013). Enhanced Subpixel Morphological Antialiasing.
+ * http://www.iryoku.com/smaa/
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "NativePipeline.h"
+#include "AreaTable.h"
+#include "SearchTable.h"
+#include "Simd.h"
+#include "Trace.h"
+
+
+namespace {
+
+// SMAA Variables, matching the kernels.
+const float THRESHOLD = 0.05f;
+const float LOCAL_CONTRAST_ADAPTATION_FACTOR = 2.0f;
+const float LUMA_WEIGHTS[4] = {0.2126f, 0.7152f, 0.0722f, 1.0f};
+
+const int MAX_SEARCH_STEPS = SMAA_MAX_SEARCH_STEPS;
+const int MAX_SEARCH_STEPS_DIAG = SMAA_MAX_SEARCH_STEPS_DIAG;
+
+const float MAX_DISTANCE = (float) AREATABLE_MAX_DISTANCE;
+const float MAX_DISTANCE_DIAG = (float) AREATABLE_MAX_DISTANCE_DIAG;
+
+// Scale converting values of the area table to normalized values.
+#if AREATABLE_PRECISION == 8
+const float AREA_SCALE = 1.0f / 255.0f;
+#elif AREATABLE_PRECISION == 16
+const float AREA_SCALE = 1.0f / 65535.0f;
+#else
+const float AREA_SCALE = 1.0f;
+#endif
+
+// Bilinear weights of the search fetches, scaled by 32 and ordered as
+// top-left, top-right, bottom-left and bottom-right pixels.
+const int SEARCH_LEFT_WEIGHTS[4] = {1, 3, 7, 21};
+const int SEARCH_RIGHT_WEIGHTS[4] = {3, 1, 21, 7};
+const int SEARCH_UP_WEIGHTS[4] = {1, 7, 3, 21};
+const int SEARCH_DOWN_WEIGHTS[4] = {3, 21, 1, 7};
+
+// Relative cost of blending weights per pixel with a top edge, with a left
+// edge, per run of edges (whose ends are searched and often diagonal) and
+// per pixel scanned, fitted on timings of synthetic scenes.
+const float TOP_EDGE_COST = 1.0f;
+const float LEFT_EDGE_COST = 0.8f;
+const float EDGE_RUN_COST = 0.45f;
+const float PIXEL_COST = 1.0f / 768.0f;
+
+// Tiles costing more than this fraction of the share of each worker are
+// split for the blending weight stages.
+const int SPLIT_FRACTION = 4;
+
+inline int clamp(int value, int low, int high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+
+/**
+ * Pixels along a row which let horizontal searches continue: pixels with a
+ * top edge and without left edge on the pixel or the one above.
+ */
+struct RowContinuation
+{
+    RowContinuation(const Nuke::EdgeBitmap& edges, int y)
+        : top(edges.top_row(y))
+        , left(edges.left_row(y))
+        , left_above(edges.left_row(std::max(y - 1, 0)))
+    {}
+
+    uint64_t operator()(int index) const {
+        return top[index] & ~(left[index] | left_above[index]);
+    }
+
+    const uint64_t* top;
+    const uint64_t* left;
+    const uint64_t* left_above;
+};
+
+/**
+ * Pixels along a column which let vertical searches continue: pixels with a
+ * left edge and without top edge on the pixel or the one on the left.
+ */
+struct ColumnContinuation
+{
+    ColumnContinuation(const Nuke::EdgeBitmap& edges, int x)
+        : left(edges.left_column(x))
+        , top(edges.top_column(x))
+        , top_left(edges.top_column(std::max(x - 1, 0)))
+    {}
+
+    uint64_t operator()(int index) const {
+        return left[index] & ~(top[index] | top_left[index]);
+    }
+
+    const uint64_t* left;
+    const uint64_t* top;
+    const uint64_t* top_left;
+};
+
+// Count consecutive set bits from position downward, capped at limit.
+// Positions below zero are clamped, so the run never ends once it reaches
+// the first bit.
+template<typename Words>
+int count_run_down(const Words& words, int position, int limit)
+{
+    int count = 0;
+    int index = position >> 6;
+    int bit = position & 63;
+
+    while (count < limit) {
+        const uint64_t breaks = Nuke::low_bits(~words(index), bit + 1);
+        if (breaks) {
+            count += bit - Nuke::highest_bit(breaks);
+            break;
+        }
+
+        count += bit + 1;
+        if (--index < 0) {
+            return limit;
+        }
+        bit = 63;
+    }
+
+    return std::min(count, limit);
+}
+
+// Count consecutive set bits from position upward, capped at limit.
+// Positions from size are clamped to the last bit.
+template<typename Words>
+int count_run_up(const Words& words, int position, int size, int limit)
+{
+    if (position >= size) {
+        const int last = size - 1;
+        return ((words(last >> 6) >> (last & 63)) & 1) ? limit : 0;
+    }
+
+    int count = 0;
+    int index = position >> 6;
+    int bit = position & 63;
+
+    while (count < limit) {
+        // Bits beyond size are never set, so they end the run.
+        const uint64_t breaks = ~words(index) >> bit;
+        if (breaks) {
+            const int offset = Nuke::lowest_bit(breaks);
+            if (index * 64 + bit + offset >= size) {
+                return limit;
+            }
+
+            count += offset;
+            break;
+        }
+
+        count += 64 - bit;
+        index++;
+        bit = 0;
+
+        if (index * 64 >= size) {
+            return limit;
+        }
+    }
+
+    return std::min(count, limit);
+}
+
+// Bilinear fetch of edges between pixel (x, y) and pixel (x + 1, y + 1),
+// scaled by 32.
+template<int (Nuke::EdgeBitmap::*Fetch)(int, int) const>
+inline int fetch_edges(
+    const Nuke::EdgeBitmap& edges, int x, int y, const int weights[4]
+)
+{
+    return (
+        weights[0] * (edges.*Fetch)(x, y)
+        + weights[1] * (edges.*Fetch)(x + 1, y)
+        + weights[2] * (edges.*Fetch)(x, y + 1)
+        + weights[3] * (edges.*Fetch)(x + 1, y + 1)
+    );
+}
+
+// Return number of pixels to step back from the end of a search, as
+// encoded in the search table for fetched edges.
+inline int search_step(int e1, int e2, int side)
+{
+    const float length = searchTable[
+        e2 * SEARCHTABLE_WIDTH + e1 + side * (SEARCHTABLE_WIDTH / 2)
+    ];
+    return (int) (length * (255.0f / 127.0f) + 0.5f);
+}
+
+// Search step from last fetch of horizontal searches.
+inline int horizontal_search_step(
+    const Nuke::EdgeBitmap& edges, int x, int y, const int weights[4],
+    int side
+)
+{
+    return search_step(
+        fetch_edges<&Nuke::EdgeBitmap::left>(edges, x, y, weights),
+        fetch_edges<&Nuke::EdgeBitmap::top>(edges, x, y, weights),
+        side
+    );
+}
+
+// Search step from last fetch of vertical searches, read from column
+// bitmasks and looked up with flipped edges.
+inline int vertical_search_step(
+    const Nuke::EdgeBitmap& edges, int x, int y, const int weights[4],
+    int side
+)
+{
+    return search_step(
+        fetch_edges<&Nuke::EdgeBitmap::column_top>(edges, x, y, weights),
+        fetch_edges<&Nuke::EdgeBitmap::column_left>(edges, x, y, weights),
+        side
+    );
+}
+
+// Fetch area table with bilinear filtering.
+void sample_area(float x, float y, float* area)
+{
+    const float floor_x = std::floor(x);
+    const float floor_y = std::floor(y);
+    const float ax = x - floor_x;
+    const float ay = y - floor_y;
+
+    const int x0 = clamp((int) floor_x, 0, AREATABLE_WIDTH - 1);
+    const int x1 = clamp((int) floor_x + 1, 0, AREATABLE_WIDTH - 1);
+    const int y0 = clamp((int) floor_y, 0, AREATABLE_HEIGHT - 1);
+    const int y1 = clamp((int) floor_y + 1, 0, AREATABLE_HEIGHT - 1);
+
+    for (int c = 0; c < 2; c++) {
+        const float v00 = areaTableData[
+            (y0 * AREATABLE_WIDTH + x0) * AREATABLE_CHANNELS + c
+        ];
+        const float v10 = areaTableData[
+            (y0 * AREATABLE_WIDTH + x1) * AREATABLE_CHANNELS + c
+        ];
+        const float v01 = areaTableData[
+            (y1 * AREATABLE_WIDTH + x0) * AREATABLE_CHANNELS + c
+        ];
+        const float v11 = areaTableData[
+            (y1 * AREATABLE_WIDTH + x1) * AREATABLE_CHANNELS + c
+        ];
+
+        const float top = v00 + (v10 - v00) * ax;
+        const float bottom = v01 + (v11 - v01) * ax;
+        area[c] = (top + (bottom - top) * ay) * AREA_SCALE;
+    }
+}
+
+// Compute area corresponding to distances and rounded crossing edges.
+void area(int d1, int d2, int e1, int e2, float* weights)
+{
+    sample_area(
+        MAX_DISTANCE * e1 + std::sqrt((float) d1) + 0.5f,
+        MAX_DISTANCE * e2 + std::sqrt((float) d2) + 0.5f,
+        weights
+    );
+}
+
+// Compute area corresponding to a diagonal distance and crossing edges.
+void area_diag(float d1, float d2, float e1, float e2, float* weights)
+{
+    // Diagonal areas are on the right of the five orthogonal areas.
+    sample_area(
+        MAX_DISTANCE_DIAG * e1 + d1 + 5.0f * MAX_DISTANCE,
+        MAX_DISTANCE_DIAG * e2 + d2,
+        weights
+    );
+}
+
+// Diagonal pattern search (Pass 1), returning steps performed and setting
+// edges found at the end of the line.
+float search_diag_1(
+    const Nuke::EdgeBitmap& edges, int x, int y, int dx, int dy,
+    float* end_value, float* end_top
+)
+{
+    const float max_steps = (float) (MAX_SEARCH_STEPS_DIAG - 1);
+    float steps = -1.0f;
+    float value = 1.0f;
+
+    while (steps < max_steps && value > 0.9f) {
+        x += dx;
+        y += dy;
+        steps += 1.0f;
+
+        *end_top = (float) edges.top(x, y);
+        value = 0.5f * (edges.left(x, y) + *end_top);
+    }
+
+    *end_value = value;
+    return steps;
+}
+
+// Diagonal pattern search (Pass 2), returning steps performed and setting
+// edges found at the end of the line.
+float search_diag_2(
+    const Nuke::EdgeBitmap& edges, int x, int y, int dx, int dy,
+    float* end_value, float* end_top
+)
+{
+    const float max_steps = (float) (MAX_SEARCH_STEPS_DIAG - 1);
+    float steps = -1.0f;
+    float value = 1.0f;
+
+    while (steps < max_steps && value > 0.9f) {
+        x += dx;
+        y += dy;
+        steps += 1.0f;
+
+        *end_top = (float) edges.top(x, y);
+        value = 0.5f * (edges.left(x + 1, y) + *end_top);
+    }
+
+    *end_value = value;
+    return steps;
+}
+
+// Convert pixel component between types, through normalized float values
+// when types differ.
+template<typename Input, typename Output>
+struct Convert
+{
+    static Output apply(Input value) {
+        return Nuke::PixelTraits<Output>::from_float(
+            Nuke::PixelTraits<Input>::raw(value)
+            * Nuke::PixelTraits<Input>::scale()
+        );
+    }
+};
+
+template<typename T>
+struct Convert<T, T>
+{
+    static T apply(T value) { return value; }
+};
+
+// Copy bytes, with streaming stores if requested.
+inline void copy_bytes(
+    void* destination, const void* source, size_t bytes, bool stream
+)
+{
+    if (stream) {
+        Nuke::stream_copy(destination, source, bytes);
+    }
+    else {
+        std::memcpy(destination, source, bytes);
+    }
+}
+
+// Copy pixels from x0 to x1 along row, converting components between types.
+template<typename Input, typename Output>
+struct CopyRun
+{
+    static void apply(
+        const Nuke::ImageView<const Input>& input,
+        const Nuke::ImageView<Output>& output,
+        int x0, int x1, int y, int components, bool
+    ) {
+        for (int x = x0; x < x1; x++) {
+            const Input* source = input.pixel(x, y);
+            Output* destination = output.pixel(x, y);
+
+            for (int c = 0; c < components; c++) {
+                destination[c * output.channel_stride] = (
+                    Convert<Input, Output>::apply(
+                        source[c * input.channel_stride]
+                    )
+                );
+            }
+        }
+    }
+};
+
+// Copy pixels as blocks of bytes when both views share the same type, as a
+// single block when pixels are packed or as one block per plane when
+// planar, with streaming stores if requested.
+template<typename T>
+struct CopyRun<T, T>
+{
+    static void apply(
+        const Nuke::ImageView<const T>& input,
+        const Nuke::ImageView<T>& output,
+        int x0, int x1, int y, int components, bool stream
+    ) {
+        if (x1 <= x0) {
+            return;
+        }
+
+        const size_t count = x1 - x0;
+        const T* source = input.pixel(x0, y);
+        T* destination = output.pixel(x0, y);
+
+        const bool packed = (
+            input.pixel_stride == components
+            && output.pixel_stride == components
+            && input.channel_stride == 1 && output.channel_stride == 1
+        );
+
+        if (packed) {
+            copy_bytes(
+                destination, source, count * components * sizeof(T), stream
+            );
+        }
+        else if (input.pixel_stride == 1 && output.pixel_stride == 1) {
+            for (int c = 0; c < components; c++) {
+                copy_bytes(
+                    destination + c * output.channel_stride,
+                    source + c * input.channel_stride, count * sizeof(T),
+                    stream
+                );
+            }
+        }
+        else {
+            for (int x = x0; x < x1; x++) {
+                const T* pixel = input.pixel(x, y);
+                T* target = output.pixel(x, y);
+
+                for (int c = 0; c < components; c++) {
+                    target[c * output.channel_stride] = (
+                        pixel[c * input.channel_stride]
+                    );
+                }
+            }
+        }
+    }
+};
+
+// Add sample of input interpolated between the two pixels around position
+// offset from pixel along one axis, normalized and multiplied by weight, to
+// color. Blending offsets are always along a single axis, so that two
+// pixels are read instead of the four of a bilinear sample.
+template<typename Input>
+void sample_input(
+    const Nuke::ImageView<const Input>& input, int x, int y,
+    bool horizontal, float offset, float weight, float* color
+)
+{
+    typedef Nuke::PixelTraits<Input> Traits;
+
+    const float position = (float) (horizontal ? x : y) + offset;
+    const float floor_position = std::floor(position);
+    const float alpha = position - floor_position;
+
+    const int last = horizontal ? input.width - 1 : input.height - 1;
+    const int p0 = clamp((int) floor_position, 0, last);
+    const int p1 = clamp((int) floor_position + 1, 0, last);
+
+    const Input* first = horizontal ? input.pixel(p0, y) : input.pixel(x, p0);
+    const Input* second = horizontal ? input.pixel(p1, y) : input.pixel(x, p1);
+
+    weight *= Traits::scale();
+
+    const int components = std::min(input.components, 4);
+    for (int c = 0; c < components; c++) {
+        const std::ptrdiff_t index = c * input.channel_stride;
+        const float v0 = Traits::raw(first[index]);
+        color[c] += weight * (v0 + (Traits::raw(second[index]) - v0) * alpha);
+    }
+}
+
+} // namespace
+
+
+namespace Nuke {
+
+Tile::Tile()
+    : x0(0), y0(0), x1(0), y1(0)
+{
+}
+
+Tile::Tile(int x0, int y0, int x1, int y1)
+    : x0(x0), y0(y0), x1(x1), y1(y1)
+{
+}
+
+NativePipeline::NativePipeline()
+    : _width(0)
+    , _height(0)
+    , _tile_width(0)
+    , _tile_height(0)
+    , _tile_bands(0)
+    , _weight_precision(WEIGHTS_FLOAT)
+{
+}
+
+const char* NativePipeline::stage_name(Stage stage)
+{
+    static const char* const NAMES[STAGE_COUNT] = {
+        "luma", "edges", "columns", "horizontal weights", "vertical weights",
+        "neighborhood"
+    };
+
+    return stage >= 0 && stage < STAGE_COUNT ? NAMES[stage] : "unknown";
+}
+
+int NativePipeline::row_radius()
+{
+    // Searches step over two pixels at a time, edges depend on luma of the
+    // two rows above and the one below, and blending reads weights of the
+    // row below.
+    return 2 * std::max(MAX_SEARCH_STEPS, MAX_SEARCH_STEPS_DIAG) + 4;
+}
+
+void NativePipeline::set_weight_precision(WeightPrecision precision)
+{
+    _weight_precision = precision;
+}
+
+float NativePipeline::weight(int x, int y, int component) const
+{
+    const size_t index = ((size_t) y * _width + x) * 4 + component;
+
+    switch (_weight_precision) {
+        case WEIGHTS_UNORM8:
+            return _weights8[index] * (1.0f / 255.0f);
+        case WEIGHTS_UNORM16:
+            return _weights16[index] * (1.0f / 65535.0f);
+        case WEIGHTS_FLOAT:
+            break;
+    }
+    return _weights32[index];
+}
+
+void NativePipeline::store_weights(
+    int x, int y, int component, int count, const float* weights
+)
+{
+    const size_t index = ((size_t) y * _width + x) * 4 + component;
+
+    switch (_weight_precision) {
+        case WEIGHTS_UNORM8:
+            for (int c = 0; c < count; c++) {
+                _weights8[index + c] = PixelTraits<uint8_t>::from_float(
+                    weights[c]
+                );
+            }
+            return;
+        case WEIGHTS_UNORM16:
+            for (int c = 0; c < count; c++) {
+                _weights16[index + c] = PixelTraits<uint16_t>::from_float(
+                    weights[c]
+                );
+            }
+            return;
+        case WEIGHTS_FLOAT:
+            break;
+    }
+
+    for (int c = 0; c < count; c++) {
+        _weights32[index + c] = weights[c];
+    }
+}
+
+void NativePipeline::clear_weights(int x0, int x1, int y)
+{
+    const size_t start = ((size_t) y * _width + x0) * 4;
+    const size_t end = ((size_t) y * _width + x1) * 4;
+
+    switch (_weight_precision) {
+        case WEIGHTS_UNORM8:
+            std::fill(_weights8.data() + start, _weights8.data() + end, 0);
+            return;
+        case WEIGHTS_UNORM16:
+            std::fill(_weights16.data() + start, _weights16.data() + end, 0);
+            return;
+        case WEIGHTS_FLOAT:
+            break;
+    }
+    std::fill(_weights32.data() + start, _weights32.data() + end, 0.0f);
+}
+
+void NativePipeline::resize(
+    int width, int height, int tile_width, int tile_height
+)
+{
+    // Tiles are aligned on blocks of 64x64 pixels, so that each tile owns
+    // whole words of the edge bitmaps.
+    tile_width = std::max((tile_width + 63) / 64, 1) * 64;
+    tile_height = std::max((tile_height + 63) / 64, 1) * 64;
+
+    const size_t weights_size = (size_t) width * height * 4;
+    const bool weights_allocated = (
+        (_weight_precision == WEIGHTS_UNORM8
+            && _weights8.size() == weights_size)
+        || (_weight_precision == WEIGHTS_UNORM16
+            && _weights16.size() == weights_size)
+        || (_weight_precision == WEIGHTS_FLOAT
+            && _weights32.size() == weights_size)
+    );
+
+    if (
+        width == _width && height == _height
+        && tile_width == _tile_width && tile_height == _tile_height
+        && weights_allocated
+    ) {
+        return;
+    }
+
+    _width = width;
+    _height = height;
+    _tile_width = tile_width;
+    _tile_height = tile_height;
+
+    _tiles.clear();
+    for (int y = 0; y < height; y += tile_height) {
+        for (int x = 0; x < width; x += tile_width) {
+            _tiles.push_back(
+                Tile(
+                    x, y,
+                    std::min(x + tile_width, width),
+                    std::min(y + tile_height, height)
+                )
+            );
+        }
+    }
+
+    _tile_edges.assign(_tiles.size(), 0);
+    _tile_bands = tile_height / 64;
+    _band_costs.assign(_tiles.size() * _tile_bands, 0.0f);
+    _weight_schedule.clear();
+
+    _luma.resize(width * height);
+    _edges.resize(width, height);
+    _weights8.resize(_weight_precision == WEIGHTS_UNORM8 ? weights_size : 0);
+    _weights16.resize(
+        _weight_precision == WEIGHTS_UNORM16 ? weights_size : 0
+    );
+    _weights32.resize(_weight_precision == WEIGHTS_FLOAT ? weights_size : 0);
+    _vertical_rows.resize(_edges.row_words() * height);
+    _blended_rows.resize(_edges.row_words() * height);
+}
+
+size_t NativePipeline::memory_usage() const
+{
+    return (
+        _luma.size() * sizeof(float) + _edges.memory_usage()
+        + _weights8.size() + _weights16.size() * sizeof(uint16_t)
+        + _weights32.size() * sizeof(float)
+        + _vertical_rows.size() * sizeof(uint64_t)
+        + _blended_rows.size() * sizeof(uint64_t)
+        + _tiles.size() * sizeof(Tile) + _tile_edges.size()
+        + _band_costs.size() * sizeof(float)
+        + _weight_schedule.capacity() * sizeof(ScheduledTile)
+    );
+}
+
+void NativePipeline::run_stage(
+    Stage stage, int tile_index,
+    const InputView& input, const OutputView& output
+)
+{
+    if (stage == EDGES) {
+        TraceScope scope(stage_name(stage));
+        _tile_edges[tile_index] = detect_edges(
+            _tiles[tile_index], &_band_costs[tile_index * _tile_bands]
+        );
+        return;
+    }
+
+    run_stage(stage, _tiles[tile_index], input, output);
+}
+
+void NativePipeline::run_stage(
+    Stage stage, const Tile& tile,
+    const InputView& input, const OutputView& output
+)
+{
+    TraceScope scope(stage_name(stage));
+
+    switch (stage) {
+        case LUMA:
+            switch (input.type) {
+                case PIXEL_UINT8:
+                    compute_luma(input.as<const uint8_t>(), tile);
+                    break;
+                case PIXEL_UINT16:
+                    compute_luma(input.as<const uint16_t>(), tile);
+                    break;
+                case PIXEL_HALF:
+                    compute_luma(input.as<const Half>(), tile);
+                    break;
+                case PIXEL_FLOAT:
+                    compute_luma(input.as<const float>(), tile);
+                    break;
+            }
+            break;
+
+        case COLUMNS:
+            if (edges_found()) {
+                _edges.update_columns(tile.x0, tile.y0, tile.x1, tile.y1);
+            }
+            break;
+
+        case HORIZONTAL_WEIGHTS:
+            if (edges_found()) {
+                run_horizontal_pass(tile);
+            }
+            break;
+
+        case VERTICAL_WEIGHTS:
+            if (edges_found()) {
+                run_vertical_pass(tile);
+            }
+            break;
+
+        case NEIGHBORHOOD:
+            switch (input.type) {
+                case PIXEL_UINT8:
+                    run_neighborhood_stage(
+                        input.as<const uint8_t>(), output, tile
+                    );
+                    break;
+                case PIXEL_UINT16:
+                    run_neighborhood_stage(
+                        input.as<const uint16_t>(), output, tile
+                    );
+                    break;
+                case PIXEL_HALF:
+                    run_neighborhood_stage(
+                        input.as<const Half>(), output, tile
+                    );
+                    break;
+                case PIXEL_FLOAT:
+                    run_neighborhood_stage(
+                        input.as<const float>(), output, tile
+                    );
+                    break;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void NativePipeline::process(const InputView& input, const OutputView& output)
+{
+    resize(input.width, input.height, input.width, input.height);
+
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        for (int index = 0; index < (int) _tiles.size(); index++) {
+            run_stage((Stage) stage, index, input, output);
+        }
+    }
+}
+
+float NativePipeline::tile_cost(int tile_index) const
+{
+    float cost = 0.0f;
+    for (int band = 0; band < _tile_bands; band++) {
+        cost += _band_costs[tile_index * _tile_bands + band];
+    }
+
+    return cost;
+}
+
+void NativePipeline::schedule_weights(int workers)
+{
+    _weight_schedule.clear();
+
+    float total = 0.0f;
+    for (size_t index = 0; index < _band_costs.size(); index++) {
+        total += _band_costs[index];
+    }
+
+    const float target = total / (std::max(workers, 1) * SPLIT_FRACTION);
+
+    for (int index = 0; index < (int) _tiles.size(); index++) {
+        const Tile& tile = _tiles[index];
+
+        // Merge consecutive bands of tile until they reach the target cost.
+        int y0 = tile.y0;
+        float cost = 0.0f;
+
+        for (int band = 0; band < _tile_bands; band++) {
+            const int y1 = std::min(tile.y0 + (band + 1) * 64, tile.y1);
+            cost += _band_costs[index * _tile_bands + band];
+
+            if (y1 == tile.y1 || (target > 0.0f && cost >= target)) {
+                _weight_schedule.push_back(
+                    ScheduledTile(Tile(tile.x0, y0, tile.x1, y1), cost)
+                );
+                y0 = y1;
+                cost = 0.0f;
+            }
+
+            if (y1 == tile.y1) {
+                break;
+            }
+        }
+    }
+
+    std::stable_sort(
+        _weight_schedule.begin(), _weight_schedule.end(),
+        [](const ScheduledTile& first, const ScheduledTile& second) {
+            return first.cost > second.cost;
+        }
+    );
+}
+
+bool NativePipeline::edges_found() const
+{
+    for (size_t index = 0; index < _tile_edges.size(); index++) {
+        if (_tile_edges[index]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template<typename Input>
+void NativePipeline::compute_luma(
+    const ImageView<const Input>& input, const Tile& tile
+)
+{
+    typedef PixelTraits<Input> Traits;
+
+    if (input.planar()) {
+        compute_planar_luma(input, tile);
+        return;
+    }
+
+    const int components = std::min(input.components, 4);
+    const std::ptrdiff_t channel_stride = input.channel_stride;
+    const float scale = Traits::scale();
+
+    for (int y = tile.y0; y < tile.y1; y++) {
+        for (int x = tile.x0; x < tile.x1; x++) {
+            const Input* pixel = input.pixel(x, y);
+
+            float value = 0.0f;
+            for (int c = 0; c < components; c++) {
+                value += (
+                    Traits::raw(pixel[c * channel_stride]) * LUMA_WEIGHTS[c]
+                );
+            }
+
+            _luma[y * _width + x] = value * scale;
+        }
+    }
+}
+
+template<typename Input>
+void NativePipeline::compute_planar_luma(
+    const ImageView<const Input>& input, const Tile& tile
+)
+{
+    typedef PixelTraits<Input> Traits;
+
+    const int components = std::min(input.components, 4);
+    const float scale = Traits::scale();
+    const int count = tile.x1 - tile.x0;
+
+    for (int y = tile.y0; y < tile.y1; y++) {
+        float* luma = &_luma[y * _width + tile.x0];
+        const Input* row = input.pixel(tile.x0, y);
+
+        for (int x = 0; x < count; x++) {
+            luma[x] = 0.0f;
+        }
+
+        // Components are added in the same order as for interleaved input,
+        // which gives the same values.
+        for (int c = 0; c < components; c++) {
+            const Input* channel = row + c * input.channel_stride;
+            const float weight = LUMA_WEIGHTS[c];
+
+            for (int x = 0; x < count; x++) {
+                luma[x] += Traits::raw(channel[x]) * weight;
+            }
+        }
+
+        for (int x = 0; x < count; x++) {
+            luma[x] *= scale;
+        }
+    }
+}
+
+bool NativePipeline::detect_edges(const Tile& tile, float* band_costs)
+{
+    bool found = false;
+
+    // Edges and runs of edges counted over the current band of 64 rows.
+    int top_edges = 0;
+    int left_edges = 0;
+    int runs = 0;
+
+    for (int y = tile.y0; y < tile.y1; y++) {
+        const float* row = &_luma[y * _width];
+        const float* row_top = &_luma[std::max(y - 1, 0) * _width];
+        const float* row_top_top = &_luma[std::max(y - 2, 0) * _width];
+        const float* row_bottom = (
+            &_luma[std::min(y + 1, _height - 1) * _width]
+        );
+
+        uint64_t left_word = 0;
+        uint64_t top_word = 0;
+
+        // Top edge of the last pixel of the previous word, which continues
+        // runs along the row.
+        uint64_t top_carry = 0;
+
+        for (int x = tile.x0; x < tile.x1; x++) {
+            const float L = row[x];
+            const float L_left = row[std::max(x - 1, 0)];
+            const float L_top = row_top[x];
+
+            // Detect edge according to threshold.
+            const float delta_x = std::fabs(L - L_left);
+            const float delta_y = std::fabs(L - L_top);
+
+            bool edge_left = delta_x > THRESHOLD;
+            bool edge_top = delta_y > THRESHOLD;
+
+            if (edge_left || edge_top) {
+                const float L_right = row[std::min(x + 1, _width - 1)];
+                const float L_bottom = row_bottom[x];
+
+                // Calculate the maximum delta in the direct neighborhood.
+                float max_delta_x = std::max(delta_x, std::fabs(L - L_right));
+                float max_delta_y = std::max(delta_y, std::fabs(L - L_bottom));
+
+                const float L_left_left = row[std::max(x - 2, 0)];
+                const float L_top_top = row_top_top[x];
+
+                // Calculate the final maximum delta.
+                max_delta_x = std::max(
+                    max_delta_x, std::fabs(L_left - L_left_left)
+                );
+                max_delta_y = std::max(
+                    max_delta_y, std::fabs(L_top - L_top_top)
+                );
+                const float final_delta = std::max(max_delta_x, max_delta_y);
+
+                // Compute local contrast adaptation.
+                edge_left = (
+                    edge_left
+                    && delta_x * LOCAL_CONTRAST_ADAPTATION_FACTOR > final_delta
+                );
+                edge_top = (
+                    edge_top
+                    && delta_y * LOCAL_CONTRAST_ADAPTATION_FACTOR > final_delta
+                );
+
+                left_word |= (uint64_t) edge_left << (x & 63);
+                top_word |= (uint64_t) edge_top << (x & 63);
+            }
+
+            if ((x & 63) == 63 || x == tile.x1 - 1) {
+                const int index = x >> 6;
+                _edges.set_row_words(y, index, left_word, top_word);
+                found = found || left_word || top_word;
+
+                // Runs start on edges not continuing the edge at their left,
+                // or above for left edges.
+                const uint64_t left_above = (
+                    y > tile.y0 ? _edges.left_row(y - 1)[index] : 0
+                );
+                top_edges += bit_count(top_word);
+                left_edges += bit_count(left_word);
+                runs += bit_count(top_word & ~((top_word << 1) | top_carry));
+                runs += bit_count(left_word & ~left_above);
+
+                top_carry = top_word >> 63;
+                left_word = 0;
+                top_word = 0;
+            }
+        }
+
+        if ((y - tile.y0) % 64 == 63 || y == tile.y1 - 1) {
+            const int pixels = (tile.x1 - tile.x0) * ((y - tile.y0) % 64 + 1);
+            band_costs[(y - tile.y0) / 64] = (
+                top_edges * TOP_EDGE_COST + left_edges * LEFT_EDGE_COST
+                + runs * EDGE_RUN_COST + pixels * PIXEL_COST
+            );
+            top_edges = 0;
+            left_edges = 0;
+            runs = 0;
+        }
+    }
+
+    return found;
+}
+
+void NativePipeline::run_horizontal_pass(const Tile& tile)
+{
+    const int row_words = _edges.row_words();
+    const int index_start = tile.x0 / 64;
+    const int index_end = (tile.x1 + 63) / 64;
+
+    for (int y = tile.y0; y < tile.y1; y++) {
+        const uint64_t* top_row = _edges.top_row(y);
+        const uint64_t* left_row = _edges.left_row(y);
+
+        clear_weights(tile.x0, tile.x1, y);
+
+        for (int index = index_start; index < index_end; index++) {
+            uint64_t pixels = top_row[index];
+            uint64_t vertical = left_row[index];
+            uint64_t blended = 0;
+
+            // Only visit pixels with edges at North.
+            while (pixels) {
+                const int offset = lowest_bit(pixels);
+                const int x = index * 64 + offset;
+                pixels &= pixels - 1;
+
+                float weights[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                if (calculate_top_weights(x, y, weights)) {
+                    vertical &= ~(uint64_t(1) << offset);
+                }
+                store_weights(x, y, 0, 4, weights);
+
+                if (weights[0] || weights[1] || weights[2] || weights[3]) {
+                    blended |= uint64_t(1) << offset;
+                }
+            }
+
+            _vertical_rows[y * row_words + index] = vertical;
+            _blended_rows[y * row_words + index] = blended;
+        }
+    }
+}
+
+void NativePipeline::run_vertical_pass(const Tile& tile)
+{
+    const int row_words = _edges.row_words();
+
+    uint64_t block[64];
+    float block_weights[64 * 64 * 2];
+
+    for (int y0 = tile.y0; y0 < tile.y1; y0 += 64) {
+        const int block_height = std::min(tile.y1 - y0, 64);
+
+        for (int x0 = tile.x0; x0 < tile.x1; x0 += 64) {
+            const int block_x = x0 / 64;
+
+            bool empty = true;
+            for (int y = 0; y < 64; y++) {
+                block[y] = 0;
+                if (y < block_height) {
+                    block[y] = _vertical_rows[(y0 + y) * row_words + block_x];
+                }
+                empty = empty && !block[y];
+            }
+
+            if (empty) {
+                continue;
+            }
+
+            // Edges at West, column by column.
+            transpose_bits(block);
+
+            for (int column = 0; column < 64; column++) {
+                uint64_t pixels = block[column];
+
+                while (pixels) {
+                    const int row = lowest_bit(pixels);
+                    pixels &= pixels - 1;
+
+                    calculate_left_weights(
+                        x0 + column, y0 + row,
+                        &block_weights[(column * 64 + row) * 2]
+                    );
+                }
+            }
+
+            // Write weights back row by row.
+            for (int row = 0; row < block_height; row++) {
+                const int y = y0 + row;
+                uint64_t pixels = _vertical_rows[y * row_words + block_x];
+
+                while (pixels) {
+                    const int column = lowest_bit(pixels);
+                    pixels &= pixels - 1;
+
+                    const float* weights = (
+                        &block_weights[(column * 64 + row) * 2]
+                    );
+                    store_weights(x0 + column, y, 2, 2, weights);
+
+                    if (weights[0] || weights[1]) {
+                        _blended_rows[y * row_words + block_x] |= (
+                            uint64_t(1) << column
+                        );
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool NativePipeline::calculate_top_weights(int x, int y, float* weights) const
+{
+    calculate_diag_weights(x, y, weights);
+
+    // We give priority to diagonals, so if we find a diagonal we skip
+    // horizontal / vertical processing.
+    if (weights[0] != -weights[1]) {
+        return true;
+    }
+
+    const RowContinuation continuation(_edges, y);
+    const int limit = 2 * MAX_SEARCH_STEPS;
+
+    // Each step of the search covers two pixels, and the last step
+    // performed is the one failing on the first pixel not continuing.
+    const int steps_left = std::min(
+        count_run_down(continuation, x, limit) / 2, MAX_SEARCH_STEPS - 1
+    );
+    const int steps_right = std::min(
+        count_run_up(continuation, x + 1, _width, limit) / 2,
+        MAX_SEARCH_STEPS - 1
+    );
+
+    // Find the distance to the left.
+    const int left = x - 2 * steps_left + 1 - horizontal_search_step(
+        _edges, x - 1 - 2 * steps_left, y - 1, SEARCH_LEFT_WEIGHTS, 0
+    );
+
+    // Find the distance to the right.
+    const int right = x + 2 * steps_right + horizontal_search_step(
+        _edges, x + 1 + 2 * steps_right, y - 1, SEARCH_RIGHT_WEIGHTS, 1
+    );
+
+    // Fetch the crossing edges, rounded as expected by the area table.
+    const int e1 = _edges.left(left, y - 1) + 3 * _edges.left(left, y);
+    const int e2 = _edges.left(right + 1, y - 1) + 3 * _edges.left(right + 1, y);
+
+    area(std::abs(left - x), std::abs(right - x), e1, e2, weights);
+    return false;
+}
+
+void NativePipeline::calculate_left_weights(int x, int y, float* weights) const
+{
+    const ColumnContinuation continuation(_edges, x);
+    const int limit = 2 * MAX_SEARCH_STEPS;
+
+    const int steps_up = std::min(
+        count_run_down(continuation, y, limit) / 2, MAX_SEARCH_STEPS - 1
+    );
+    const int steps_down = std::min(
+        count_run_up(continuation, y + 1, _height, limit) / 2,
+        MAX_SEARCH_STEPS - 1
+    );
+
+    // Find the distance to the top.
+    const int top = y - 2 * steps_up + 1 - vertical_search_step(
+        _edges, x - 1, y - 1 - 2 * steps_up, SEARCH_UP_WEIGHTS, 0
+    );
+
+    // Find the distance to the bottom.
+    const int bottom = y + 2 * steps_down + vertical_search_step(
+        _edges, x - 1, y + 1 + 2 * steps_down, SEARCH_DOWN_WEIGHTS, 1
+    );
+
+    // Fetch the crossing edges, rounded as expected by the area table.
+    const int e1 = (
+        _edges.column_top(x - 1, top) + 3 * _edges.column_top(x, top)
+    );
+    const int e2 = (
+        _edges.column_top(x - 1, bottom + 1)
+        + 3 * _edges.column_top(x, bottom + 1)
+    );
+
+    area(std::abs(top - y), std::abs(bottom - y), e1, e2, weights);
+}
+
+void NativePipeline::calculate_diag_weights(int x, int y, float* weights) const
+{
+    float area[2];
+    float end_value;
+    float end_top;
+
+    // Search for the line ends.
+    float d[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    if (_edges.left(x, y)) {
+        d[0] = search_diag_1(_edges, x, y, -1, 1, &end_value, &end_top);
+        d[0] += end_top > 0.9f ? 1.0f : 0.0f;
+        d[2] = end_value;
+    }
+
+    d[1] = search_diag_1(_edges, x, y, 1, -1, &end_value, &end_top);
+    d[3] = end_value;
+
+    if (d[0] + d[1] > 2.0f) {
+        const int x1 = x - (int) d[0];
+        const int y1 = y + (int) d[0];
+        const int x2 = x + (int) d[1];
+        const int y2 = y - (int) d[1];
+
+        // Fetch the crossing edges and merge them at each side into a
+        // single value, removing them if we didn't found the end of the
+        // line.
+        const float c1 = d[2] > 0.9f ? 0.0f : (float) (
+            2 * _edges.top(x1 - 1, y1) + _edges.left(x1, y1)
+        );
+        const float c2 = d[3] > 0.9f ? 0.0f : (float) (
+            2 * _edges.top(x2 + 1, y2) + _edges.left(x2 + 1, y2 - 1)
+        );
+
+        // Fetch the areas for this line.
+        area_diag(d[0], d[1], c1, c2, area);
+        weights[0] += area[0];
+        weights[1] += area[1];
+    }
+
+    // Search for the line ends.
+    d[0] = search_diag_2(_edges, x, y, -1, -1, &end_value, &end_top);
+    d[2] = end_value;
+
+    if (_edges.left(x + 1, y)) {
+        d[1] = search_diag_2(_edges, x, y, 1, 1, &end_value, &end_top);
+        d[1] += end_top > 0.9f ? 1.0f : 0.0f;
+        d[3] = end_value;
+    }
+    else {
+        d[1] = 0.0f;
+        d[3] = 0.0f;
+    }
+
+    if (d[0] + d[1] > 2.0f) {
+        const int x1 = x - (int) d[0];
+        const int y1 = y - (int) d[0];
+        const int x2 = x + (int) d[1];
+        const int y2 = y + (int) d[1];
+
+        const float c1 = d[2] > 0.9f ? 0.0f : (float) (
+            2 * _edges.top(x1 - 1, y1) + _edges.left(x1, y1 - 1)
+        );
+        const float c2 = d[3] > 0.9f ? 0.0f : (float) (
+            2 * _edges.top(x2 + 1, y2) + _edges.left(x2 + 1, y2)
+        );
+
+        area_diag(d[0], d[1], c1, c2, area);
+        weights[0] += area[1];
+        weights[1] += area[0];
+    }
+}
+
+template<typename Input>
+void NativePipeline::run_neighborhood_stage(
+    const ImageView<const Input>& input, const OutputView& output,
+    const Tile& tile
+)
+{
+    switch (output.type) {
+        case PIXEL_UINT8:
+            run_neighborhood_stage(input, output.as<uint8_t>(), tile);
+            break;
+        case PIXEL_UINT16:
+            run_neighborhood_stage(input, output.as<uint16_t>(), tile);
+            break;
+        case PIXEL_HALF:
+            run_neighborhood_stage(input, output.as<Half>(), tile);
+            break;
+        case PIXEL_FLOAT:
+            run_neighborhood_stage(input, output.as<float>(), tile);
+            break;
+    }
+}
+
+template<typename Input, typename Output>
+void NativePipeline::run_neighborhood_stage(
+    const ImageView<const Input>& input, const ImageView<Output>& output,
+    const Tile& tile
+)
+{
+    // Without edges, there is nothing to blend.
+    if (edges_found()) {
+        run_neighborhood_blending(input, output, tile);
+    }
+    else {
+        copy_input(input, output, tile);
+    }
+
+    // Output is written with streaming stores when SIMD is available.
+    if (simd_available()) {
+        stream_fence();
+    }
+}
+
+template<typename Input, typename Output>
+void NativePipeline::copy_input(
+    const ImageView<const Input>& input, const ImageView<Output>& output,
+    const Tile& tile
+)
+{
+    const bool stream = simd_available();
+
+    for (int y = tile.y0; y < tile.y1; y++) {
+        CopyRun<Input, Output>::apply(
+            input, output, tile.x0, tile.x1, y, output.components, stream
+        );
+    }
+}
+
+template<typename Input, typename Output>
+bool NativePipeline::use_simd(
+    const ImageView<const Input>&, const ImageView<Output>&
+) const
+{
+    return false;
+}
+
+bool NativePipeline::use_simd(
+    const ImageView<const float>& input, const ImageView<float>& output
+) const
+{
+    if (!simd_available() || output.components < 1) {
+        return false;
+    }
+
+    // Input is sampled with gathers, from signed 32-bit offsets.
+    if (
+        input.pixel_stride < 0 || input.row_stride < 0
+        || input.channel_stride < 0
+    ) {
+        return false;
+    }
+
+    const std::ptrdiff_t extent = (
+        (std::ptrdiff_t) (input.height - 1) * input.row_stride
+        + (std::ptrdiff_t) (input.width - 1) * input.pixel_stride
+        + (std::ptrdiff_t) (std::min(input.components, 4) - 1)
+            * input.channel_stride
+    );
+    return extent <= std::numeric_limits<int>::max();
+}
+
+template<typename Input, typename Output>
+void NativePipeline::blend_group(
+    const ImageView<const Input>& input, const ImageView<Output>& output,
+    int x, int y
+) const
+{
+    const int components = std::min(output.components, 4);
+
+    for (int pixel_x = x; pixel_x < x + 8; pixel_x++) {
+        if (!blend_pixel(input, output, pixel_x, y)) {
+            CopyRun<Input, Output>::apply(
+                input, output, pixel_x, pixel_x + 1, y, components, false
+            );
+        }
+    }
+}
+
+void NativePipeline::blend_group(
+    const ImageView<const float>& input, const ImageView<float>& output,
+    int x, int y
+) const
+{
+    const size_t index = ((size_t) y * _width + x) * 4;
+    const size_t bottom_index = (
+        ((size_t) std::min(y + 1, _height - 1) * _width + x) * 4
+    );
+
+    GroupWeights weights;
+    weights.precision = _weight_precision;
+
+    switch (_weight_precision) {
+        case WEIGHTS_UNORM8:
+            weights.current = &_weights8[index];
+            weights.right = &_weights8[index + 4];
+            weights.bottom = &_weights8[bottom_index];
+            break;
+        case WEIGHTS_UNORM16:
+            weights.current = &_weights16[index];
+            weights.right = &_weights16[index + 4];
+            weights.bottom = &_weights16[bottom_index];
+            break;
+        case WEIGHTS_FLOAT:
+            weights.current = &_weights32[index];
+            weights.right = &_weights32[index + 4];
+            weights.bottom = &_weights32[bottom_index];
+            break;
+    }
+
+    blend_group_avx2(input, output, x, y, weights);
+}
+
+uint64_t NativePipeline::blending_candidates(int y, int index) const
+{
+    const int row_words = _edges.row_words();
+    const uint64_t* row = &_blended_rows[y * row_words];
+    const uint64_t* bottom_row = &_blended_rows[
+        std::min(y + 1, _height - 1) * row_words
+    ];
+
+    // Shift weights of pixels at the right onto pixels they blend.
+    uint64_t right = row[index] >> 1;
+    if (index + 1 < row_words) {
+        right |= row[index + 1] << 63;
+    }
+
+    return row[index] | right | bottom_row[index];
+}
+
+template<typename Input, typename Output>
+void NativePipeline::run_neighborhood_blending(
+    const ImageView<const Input>& input, const ImageView<Output>& output,
+    const Tile& tile
+)
+{
+    const int components = std::min(output.components, 4);
+
+    const int index_start = tile.x0 / 64;
+    const int index_end = (tile.x1 + 63) / 64;
+
+    const bool simd = use_simd(input, output);
+    const bool stream = simd_available();
+
+    for (int y = tile.y0; y < tile.y1; y++) {
+        // Start of the current run of pixels left untouched, copied at once
+        // when reaching a blended pixel or the end of the row.
+        int run_start = tile.x0;
+
+        for (int index = index_start; index < index_end; index++) {
+            uint64_t pixels = blending_candidates(y, index);
+
+            while (pixels) {
+                const int offset = lowest_bit(pixels);
+
+                // With SIMD, groups of 8 pixels holding candidates are
+                // blended at once, including pixels left untouched.
+                const int group = offset & ~7;
+                const int group_x = index * 64 + group;
+
+                if (simd && group_x + 8 < _width) {
+                    CopyRun<Input, Output>::apply(
+                        input, output, run_start, group_x, y, components,
+                        stream
+                    );
+                    blend_group(input, output, group_x, y);
+                    run_start = group_x + 8;
+                    pixels &= ~(uint64_t(0xff) << group);
+                    continue;
+                }
+
+                const int x = index * 64 + offset;
+                pixels &= pixels - 1;
+
+                // Pixels left untouched are copied along with the run.
+                if (blend_pixel(input, output, x, y)) {
+                    CopyRun<Input, Output>::apply(
+                        input, output, run_start, x, y, components, stream
+                    );
+                    run_start = x + 1;
+                }
+            }
+        }
+
+        CopyRun<Input, Output>::apply(
+            input, output, run_start, tile.x1, y, components, stream
+        );
+    }
+}
+
+template<typename Input, typename Output>
+bool NativePipeline::blend_pixel(
+    const ImageView<const Input>& input, const ImageView<Output>& output,
+    int x, int y
+) const
+{
+    const int components = std::min(output.components, 4);
+    const int x_right = std::min(x + 1, _width - 1);
+    const int y_bottom = std::min(y + 1, _height - 1);
+
+    // Fetch the blending weights for current pixel.
+    const float a[4] = {
+        weight(x_right, y, 3),
+        weight(x, y_bottom, 1),
+        weight(x, y, 2),
+        weight(x, y, 0)
+    };
+
+    if (a[0] + a[1] + a[2] + a[3] < 0.01f) {
+        return false;
+    }
+
+    const bool h = std::max(a[0], a[2]) > std::max(a[1], a[3]);
+
+    // Pixels are blended with the pixels on both sides along one axis.
+    float offset[2] = {a[1], -a[3]};
+    float weight[2] = {a[1], a[3]};
+
+    if (h) {
+        offset[0] = a[0];
+        offset[1] = -a[2];
+        weight[0] = a[0];
+        weight[1] = a[2];
+    }
+
+    const float sum = weight[0] + weight[1];
+    weight[0] /= sum;
+    weight[1] /= sum;
+
+    float color[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    sample_input(input, x, y, h, offset[0], weight[0], color);
+    sample_input(input, x, y, h, offset[1], weight[1], color);
+
+    Output* destination = output.pixel(x, y);
+    for (int c = 0; c < components; c++) {
+        destination[c * output.channel_stride] = (
+            PixelTraits<Output>::from_float(color[c])
+        );
+    }
+
+    return true;
+}
+
+} // namespace Nuke
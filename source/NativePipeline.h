@@ -0,0 +1,472 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_NATIVE_PIPELINE_H
+#define SMAA_NUKE_NATIVE_PIPELINE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "Buffer.h"
+#include "EdgeBitmap.h"
+#include "Half.h"
+
+
+namespace Nuke {
+
+/**
+ * View over pixels, with strides expressed in elements.
+ *
+ * Components of a pixel are channel_stride apart, which is 1 for
+ * interleaved pixels and the distance between channel planes for planar
+ * pixels.
+ */
+template<typename T>
+struct ImageView
+{
+    ImageView()
+        : data(0), width(0), height(0), components(0)
+        , pixel_stride(0), row_stride(0), channel_stride(1)
+    {}
+
+    ImageView(
+        T* data, int width, int height, int components,
+        std::ptrdiff_t pixel_stride, std::ptrdiff_t row_stride,
+        std::ptrdiff_t channel_stride = 1
+    )
+        : data(data), width(width), height(height), components(components)
+        , pixel_stride(pixel_stride), row_stride(row_stride)
+        , channel_stride(channel_stride)
+    {}
+
+    // Return first component of pixel.
+    T* pixel(int x, int y) const {
+        return data + y * row_stride + x * pixel_stride;
+    }
+
+    // Return whether components are stored in separate planes, with
+    // contiguous rows.
+    bool planar() const { return pixel_stride == 1 && channel_stride != 1; }
+
+    T* data;
+    int width;
+    int height;
+    int components;
+    std::ptrdiff_t pixel_stride;
+    std::ptrdiff_t row_stride;
+    std::ptrdiff_t channel_stride;
+};
+
+/**
+ * Types of pixel components handled by the native pipeline.
+ */
+enum PixelType
+{
+    PIXEL_UINT8,
+    PIXEL_UINT16,
+    PIXEL_HALF,
+    PIXEL_FLOAT
+};
+
+/**
+ * Conversion of pixel components to and from normalized float values.
+ *
+ * Values are normalized as raw(value) * scale, so that sums of integer
+ * components can be scaled once.
+ */
+template<typename T>
+struct PixelTraits;
+
+template<>
+struct PixelTraits<uint8_t>
+{
+    static const PixelType type = PIXEL_UINT8;
+
+    static float raw(uint8_t value) { return (float) value; }
+    static float scale() { return 1.0f / 255.0f; }
+
+    static uint8_t from_float(float value)
+    {
+        if (!(value > 0.0f)) {
+            return 0;
+        }
+        return value >= 1.0f ? 255 : (uint8_t) (value * 255.0f + 0.5f);
+    }
+};
+
+template<>
+struct PixelTraits<uint16_t>
+{
+    static const PixelType type = PIXEL_UINT16;
+
+    static float raw(uint16_t value) { return (float) value; }
+    static float scale() { return 1.0f / 65535.0f; }
+
+    static uint16_t from_float(float value)
+    {
+        if (!(value > 0.0f)) {
+            return 0;
+        }
+        return value >= 1.0f ? 65535 : (uint16_t) (value * 65535.0f + 0.5f);
+    }
+};
+
+template<>
+struct PixelTraits<Half>
+{
+    static const PixelType type = PIXEL_HALF;
+
+    static float raw(Half value) { return (float) value; }
+    static float scale() { return 1.0f; }
+
+    static Half from_float(float value) { return Half(value); }
+};
+
+template<>
+struct PixelTraits<float>
+{
+    static const PixelType type = PIXEL_FLOAT;
+
+    static float raw(float value) { return value; }
+    static float scale() { return 1.0f; }
+
+    static float from_float(float value) { return value; }
+};
+
+/**
+ * View over pixels of any type handled, laid out as for ImageView. Type is
+ * deduced from the pointer given.
+ */
+template<typename Void>
+struct PixelView
+{
+    PixelView()
+        : data(0), type(PIXEL_FLOAT), width(0), height(0), components(0)
+        , pixel_stride(0), row_stride(0), channel_stride(1)
+    {}
+
+    template<typename T>
+    PixelView(
+        T* data, int width, int height, int components,
+        std::ptrdiff_t pixel_stride, std::ptrdiff_t row_stride,
+        std::ptrdiff_t channel_stride = 1
+    )
+        : data(data)
+        , type(PixelTraits<typename std::remove_const<T>::type>::type)
+        , width(width), height(height), components(components)
+        , pixel_stride(pixel_stride), row_stride(row_stride)
+        , channel_stride(channel_stride)
+    {}
+
+    // Allow output views to be read as input views.
+    PixelView(const PixelView<void>& other)
+        : data(other.data), type(other.type), width(other.width)
+        , height(other.height), components(other.components)
+        , pixel_stride(other.pixel_stride), row_stride(other.row_stride)
+        , channel_stride(other.channel_stride)
+    {}
+
+    // Return view with pixels of type T, which must match type.
+    template<typename T>
+    ImageView<T> as() const {
+        return ImageView<T>(
+            static_cast<T*>(data), width, height, components, pixel_stride,
+            row_stride, channel_stride
+        );
+    }
+
+    Void* data;
+    PixelType type;
+    int width;
+    int height;
+    int components;
+    std::ptrdiff_t pixel_stride;
+    std::ptrdiff_t row_stride;
+    std::ptrdiff_t channel_stride;
+};
+
+typedef PixelView<const void> InputView;
+typedef PixelView<void> OutputView;
+
+/**
+ * Region of the image processed by one task, aligned on 64 pixels.
+ */
+struct Tile
+{
+    Tile();
+    Tile(int x0, int y0, int x1, int y1);
+
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+};
+
+/**
+ * Part of a tile processed by one task of the blending weight stages, with
+ * its cost estimated from the edges found.
+ */
+struct ScheduledTile
+{
+    ScheduledTile() : cost(0.0f) {}
+    ScheduledTile(const Tile& tile, float cost) : tile(tile), cost(cost) {}
+
+    Tile tile;
+    float cost;
+};
+
+/**
+ * SMAA computed on the CPU without Blink.
+ *
+ * Follows the SMAALumaEdges, SMAABlend and SMAANeighborhood kernels, but
+ * stores edges as bitmasks so that horizontal and vertical searches are
+ * resolved with bit scans instead of stepping through bilinear fetches.
+ *
+ * The image is split into tiles, and each stage can be run on all tiles
+ * concurrently. A stage must be completed on all tiles before the next one
+ * starts, as tiles read neighbor results of the previous stages.
+ */
+class NativePipeline
+{
+public:
+    enum Stage
+    {
+        LUMA,
+        EDGES,
+        COLUMNS,
+        HORIZONTAL_WEIGHTS,
+        VERTICAL_WEIGHTS,
+        NEIGHBORHOOD,
+        STAGE_COUNT
+    };
+
+    // Storage of the four blending weights of each pixel, as normalized
+    // integers packed in 4 or 8 bytes, or as floats in 16 bytes.
+    enum WeightPrecision
+    {
+        WEIGHTS_UNORM8,
+        WEIGHTS_UNORM16,
+        WEIGHTS_FLOAT
+    };
+
+    NativePipeline();
+
+    static const char* stage_name(Stage stage);
+
+    // Return number of rows above and below a row which can affect its
+    // output, through edge detection and vertical or diagonal searches.
+    // Processing band of rows with these margins gives the same rows as
+    // processing the whole image.
+    static int row_radius();
+
+    // Prepare intermediates for frames of size, split into tiles of size
+    // rounded up to 64 pixels. Allocations are kept when nothing changed.
+    // Intermediates are left uninitialized, so that memory of each tile is
+    // first touched by the worker running its stages.
+    void resize(int width, int height, int tile_width, int tile_height);
+
+    const std::vector<Tile>& tiles() const { return _tiles; }
+
+    // Set storage of blending weights, float by default, which is applied
+    // on next resize. Smaller weights let larger tiles fit in cache, at the
+    // cost of quantizing weights and thus blending offsets.
+    void set_weight_precision(WeightPrecision precision);
+    WeightPrecision weight_precision() const { return _weight_precision; }
+
+    // Return bytes allocated for intermediates.
+    size_t memory_usage() const;
+
+    // Run stage on tile, from input to output which must have the size the
+    // pipeline was prepared for and the same number of components, up to
+    // four. Pixel types of input and output can differ, weights being
+    // computed in float in any case.
+    void run_stage(
+        Stage stage, int tile_index,
+        const InputView& input, const OutputView& output
+    );
+
+    // Run stage on part of a tile made of whole rows of 64x64 blocks, such
+    // as tiles scheduled for the blending weight stages. The edges stage
+    // can only be run per tile index.
+    void run_stage(
+        Stage stage, const Tile& tile,
+        const InputView& input, const OutputView& output
+    );
+
+    // Return cost of blending weights of tile estimated by the edges
+    // stage, in units of pixels with a top edge.
+    float tile_cost(int tile_index) const;
+
+    // Schedule blending weight stages once the edges stage was run on all
+    // tiles. Tiles costing more than a fraction of the frame shared among
+    // workers are split into bands of 64 rows, and all parts are sorted
+    // from the most to the least expensive, so that a heavily aliased
+    // region is started first and spread across workers.
+    void schedule_weights(int workers);
+
+    const std::vector<ScheduledTile>& weight_schedule() const {
+        return _weight_schedule;
+    }
+
+    // Apply SMAA from input to output on the calling thread.
+    void process(const InputView& input, const OutputView& output);
+
+    // Return whether any edge was found by the edges stage.
+    bool edges_found() const;
+
+    const EdgeBitmap& edges() const { return _edges; }
+
+    // Return blending weight of pixel, among the four stored.
+    float weight(int x, int y, int component) const;
+
+protected:
+    // Compute luma from components of input, scaled once per pixel.
+    template<typename Input>
+    void compute_luma(const ImageView<const Input>& input, const Tile& tile);
+
+    // Compute luma from planar input, one channel plane after the other
+    // over each row, so that rows are read as contiguous streams.
+    template<typename Input>
+    void compute_planar_luma(
+        const ImageView<const Input>& input, const Tile& tile
+    );
+
+    // Return whether any edge was found, and write cost of blending
+    // weights estimated for each band of 64 rows of tile.
+    bool detect_edges(const Tile& tile, float* band_costs);
+
+    // Compute weights of pixels with top edge, row by row, and record which
+    // pixels still need vertical processing.
+    void run_horizontal_pass(const Tile& tile);
+
+    // Compute weights of pixels with left edge, column by column within
+    // blocks of 64x64 pixels, so that vertical searches only read column
+    // bitmasks. Results of each block are written back to weights row by
+    // row.
+    void run_vertical_pass(const Tile& tile);
+
+    // Blend or copy tile depending on whether edges were found, once type
+    // of output is resolved.
+    template<typename Input>
+    void run_neighborhood_stage(
+        const ImageView<const Input>& input, const OutputView& output,
+        const Tile& tile
+    );
+
+    template<typename Input, typename Output>
+    void run_neighborhood_stage(
+        const ImageView<const Input>& input, const ImageView<Output>& output,
+        const Tile& tile
+    );
+
+    template<typename Input, typename Output>
+    void run_neighborhood_blending(
+        const ImageView<const Input>& input, const ImageView<Output>& output,
+        const Tile& tile
+    );
+
+    template<typename Input, typename Output>
+    void copy_input(
+        const ImageView<const Input>& input, const ImageView<Output>& output,
+        const Tile& tile
+    );
+
+    // Return whether pixels are blended with SIMD from input to output,
+    // which is only done for float images whose offsets fit in 32 bits, on
+    // processors supporting AVX2.
+    template<typename Input, typename Output>
+    bool use_simd(
+        const ImageView<const Input>& input, const ImageView<Output>& output
+    ) const;
+
+    bool use_simd(
+        const ImageView<const float>& input, const ImageView<float>& output
+    ) const;
+
+    // Blend pixel unless its weights are below threshold, and return
+    // whether it was blended.
+    template<typename Input, typename Output>
+    bool blend_pixel(
+        const ImageView<const Input>& input, const ImageView<Output>& output,
+        int x, int y
+    ) const;
+
+    // Blend group of 8 pixels from x along row, copying the pixels left
+    // untouched. Pixel at x + 8 must be within the image.
+    template<typename Input, typename Output>
+    void blend_group(
+        const ImageView<const Input>& input, const ImageView<Output>& output,
+        int x, int y
+    ) const;
+
+    void blend_group(
+        const ImageView<const float>& input, const ImageView<float>& output,
+        int x, int y
+    ) const;
+
+    // Return row bitmask of pixels from word index which may be blended,
+    // as their own weights, the weights of the pixel at their right or the
+    // weights of the pixel below are not zero.
+    uint64_t blending_candidates(int y, int index) const;
+
+    // Compute weights of pixel with top edge, following diagonal patterns
+    // then horizontal patterns. Return whether vertical processing should
+    // be skipped.
+    bool calculate_top_weights(int x, int y, float* weights) const;
+
+    // Compute the two vertical weights of pixel with left edge.
+    void calculate_left_weights(int x, int y, float* weights) const;
+
+    void calculate_diag_weights(int x, int y, float* weights) const;
+
+    // Store blending weights of pixel, from component to component + count.
+    void store_weights(
+        int x, int y, int component, int count, const float* weights
+    );
+
+    // Clear blending weights of pixels along row.
+    void clear_weights(int x0, int x1, int y);
+
+private:
+    int _width;
+    int _height;
+    int _tile_width;
+    int _tile_height;
+
+    std::vector<Tile> _tiles;
+
+    // Whether edges were found, per tile.
+    std::vector<unsigned char> _tile_edges;
+
+    // Cost of blending weights estimated from edges, per band of 64 rows
+    // of each tile, and schedule derived from it.
+    int _tile_bands;
+    std::vector<float> _band_costs;
+    std::vector<ScheduledTile> _weight_schedule;
+
+    Buffer<float> _luma;
+    EdgeBitmap _edges;
+
+    // Blending weights, four per pixel, only allocated for the precision
+    // used.
+    WeightPrecision _weight_precision;
+    Buffer<uint8_t> _weights8;
+    Buffer<uint16_t> _weights16;
+    Buffer<float> _weights32;
+
+    // Pixels needing vertical processing, as row bitmasks.
+    Buffer<uint64_t> _vertical_rows;
+
+    // Pixels with non zero blending weights, as row bitmasks.
+    Buffer<uint64_t> _blended_rows;
+};
+
+} // namespace Nuke
+
+#endif
@@ -0,0 +1,251 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "RowPipeline.h"
+#include "Trace.h"
+
+
+namespace {
+
+int round_up_64(int value)
+{
+    return std::max((value + 63) / 64 * 64, 64);
+}
+
+} // namespace
+
+
+namespace Nuke {
+
+RowPipeline::RowPipeline()
+    : _width(0)
+    , _height(0)
+    , _components(0)
+    , _band_height(default_band_height())
+    , _max_bands((size_t) default_max_bands())
+{
+}
+
+void RowPipeline::resize(int width, int height, int components)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (
+        width == _width && height == _height && components == _components
+    ) {
+        return;
+    }
+
+    _width = width;
+    _height = height;
+    _components = components;
+    _bands.clear();
+}
+
+void RowPipeline::set_band_height(int band_height)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    band_height = round_up_64(band_height);
+    if (band_height != _band_height) {
+        _band_height = band_height;
+        _bands.clear();
+    }
+}
+
+int RowPipeline::band_height() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _band_height;
+}
+
+int RowPipeline::default_band_height()
+{
+    return round_up_64(2 * NativePipeline::row_radius());
+}
+
+void RowPipeline::set_max_bands(int max_bands)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _max_bands = (size_t) std::max(max_bands, 1);
+}
+
+int RowPipeline::max_bands() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (int) _max_bands;
+}
+
+int RowPipeline::default_max_bands()
+{
+    // Threads reading rows of the same image mostly read neighboring rows,
+    // so a few bands are enough for them to share bands.
+    return 4;
+}
+
+void RowPipeline::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _bands.clear();
+}
+
+void RowPipeline::release()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _bands.clear();
+    _workspaces.clear();
+}
+
+void RowPipeline::read_row(int y, const RowReader& reader, float* row)
+{
+    bool compute = false;
+    std::shared_ptr<Band> band = acquire_band(y / _band_height, compute);
+
+    if (compute) {
+        compute_band(*band, reader);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        band->ready = true;
+        _band_ready.notify_all();
+    }
+
+    const size_t row_size = (size_t) _width * _components;
+    std::memcpy(
+        row, &band->rows[(y % _band_height) * row_size],
+        row_size * sizeof(float)
+    );
+}
+
+size_t RowPipeline::memory_usage() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t bytes = 0;
+
+    std::list<std::shared_ptr<Band> >::const_iterator band;
+    for (band = _bands.begin(); band != _bands.end(); ++band) {
+        bytes += (*band)->rows.size() * sizeof(float);
+    }
+
+    for (size_t index = 0; index < _workspaces.size(); index++) {
+        const Workspace& workspace = *_workspaces[index];
+        bytes += workspace.pipeline.memory_usage();
+        bytes += workspace.input.size() * sizeof(float);
+        bytes += workspace.output.size() * sizeof(float);
+    }
+
+    return bytes;
+}
+
+std::shared_ptr<RowPipeline::Band> RowPipeline::acquire_band(
+    int index, bool& compute
+)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    std::list<std::shared_ptr<Band> >::iterator it;
+    for (it = _bands.begin(); it != _bands.end(); ++it) {
+        if ((*it)->index == index) {
+            break;
+        }
+    }
+
+    if (it != _bands.end()) {
+        // Move band first, as most recently used.
+        std::shared_ptr<Band> band = *it;
+        _bands.splice(_bands.begin(), _bands, it);
+
+        _band_ready.wait(lock, [&band] { return band->ready; });
+        compute = false;
+        return band;
+    }
+
+    std::shared_ptr<Band> band(new Band);
+    band->index = index;
+    band->ready = false;
+    _bands.push_front(band);
+
+    // Drop least recently used bands which are ready, threads still
+    // reading them holding their own reference.
+    std::list<std::shared_ptr<Band> >::iterator last = _bands.end();
+    while (_bands.size() > _max_bands && last != _bands.begin()) {
+        --last;
+        if ((*last)->ready) {
+            last = _bands.erase(last);
+        }
+    }
+
+    compute = true;
+    return band;
+}
+
+void RowPipeline::compute_band(Band& band, const RowReader& reader)
+{
+    TraceScope scope("row band");
+
+    const int radius = NativePipeline::row_radius();
+    const int y0 = band.index * _band_height;
+    const int y1 = std::min(y0 + _band_height, _height);
+
+    // Rows of band with the margins it depends on.
+    const int top = std::max(y0 - radius, 0);
+    const int bottom = std::min(y1 + radius, _height);
+    const int rows = bottom - top;
+
+    const size_t row_size = (size_t) _width * _components;
+
+    std::unique_ptr<Workspace> workspace = acquire_workspace();
+    workspace->input.resize(rows * row_size);
+    workspace->output.resize(rows * row_size);
+
+    for (int y = top; y < bottom; y++) {
+        reader(y, &workspace->input[(y - top) * row_size]);
+    }
+
+    workspace->pipeline.process(
+        InputView(
+            workspace->input.data(), _width, rows, _components, _components,
+            row_size
+        ),
+        OutputView(
+            workspace->output.data(), _width, rows, _components, _components,
+            row_size
+        )
+    );
+
+    band.rows.resize((y1 - y0) * row_size);
+    std::memcpy(
+        band.rows.data(), &workspace->output[(y0 - top) * row_size],
+        (y1 - y0) * row_size * sizeof(float)
+    );
+
+    release_workspace(std::move(workspace));
+}
+
+std::unique_ptr<RowPipeline::Workspace> RowPipeline::acquire_workspace()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_workspaces.empty()) {
+        return std::unique_ptr<Workspace>(new Workspace);
+    }
+
+    std::unique_ptr<Workspace> workspace = std::move(_workspaces.back());
+    _workspaces.pop_back();
+    return workspace;
+}
+
+void RowPipeline::release_workspace(std::unique_ptr<Workspace> workspace)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _workspaces.push_back(std::move(workspace));
+}
+
+} // namespace Nuke
@@ -0,0 +1,118 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_ROW_PIPELINE_H
+#define SMAA_NUKE_ROW_PIPELINE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Buffer.h"
+#include "NativePipeline.h"
+
+
+namespace Nuke {
+
+/**
+ * Native pipeline producing output row by row, for row based operators.
+ *
+ * Rows are computed by bands, each band being processed along with the
+ * rows within the row radius above and below it, so that its rows match
+ * those of the whole image. The most recent bands are shared by all
+ * threads, and each thread computing a band uses a workspace of its own
+ * holding input, edge and weight rows of the band and its margins. Memory
+ * is thus bounded by the width of the image rather than its area.
+ */
+class RowPipeline
+{
+public:
+    // Fill row of input at y with interleaved components over the width.
+    typedef std::function<void(int y, float* row)> RowReader;
+
+    RowPipeline();
+
+    // Prepare for images of size with interleaved components, up to four.
+    // Cached bands are released when anything changed.
+    void resize(int width, int height, int components);
+
+    // Set number of rows computed at once, rounded up to 64 rows. Taller
+    // bands spend less time on margins but hold more memory. Defaults to
+    // twice the row radius.
+    void set_band_height(int band_height);
+    int band_height() const;
+
+    static int default_band_height();
+
+    // Set number of bands kept, so that cached rows are bounded by the
+    // number of bands times the band height. Bands being computed are kept
+    // beyond it.
+    void set_max_bands(int max_bands);
+    int max_bands() const;
+
+    static int default_max_bands();
+
+    // Release cached bands, when input changed.
+    void clear();
+
+    // Release cached bands and workspaces.
+    void release();
+
+    // Copy output row at y into row, computing its band from input rows
+    // given by reader when it is not cached. Can be called from any thread.
+    void read_row(int y, const RowReader& reader, float* row);
+
+    // Return bytes allocated for cached bands and idle workspaces.
+    size_t memory_usage() const;
+
+private:
+    struct Band
+    {
+        int index;
+        bool ready;
+        Buffer<float> rows;
+    };
+
+    struct Workspace
+    {
+        NativePipeline pipeline;
+        Buffer<float> input;
+        Buffer<float> output;
+    };
+
+    // Return band at index, and whether the calling thread must compute
+    // it. Otherwise, band is only returned once ready.
+    std::shared_ptr<Band> acquire_band(int index, bool& compute);
+
+    void compute_band(Band& band, const RowReader& reader);
+
+    std::unique_ptr<Workspace> acquire_workspace();
+    void release_workspace(std::unique_ptr<Workspace> workspace);
+
+    int _width;
+    int _height;
+    int _components;
+    int _band_height;
+    size_t _max_bands;
+
+    // Cached bands, most recently used first.
+    std::list<std::shared_ptr<Band> > _bands;
+
+    // Workspaces not used by any thread.
+    std::vector<std::unique_ptr<Workspace> > _workspaces;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _band_ready;
+};
+
+} // namespace Nuke
+
+#endif
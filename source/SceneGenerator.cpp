@@ -0,0 +1,557 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "SceneGenerator.h"
+
+
+namespace {
+
+// Glyphs of digits and uppercase letters, as 7 rows of 5 pixels with the
+// leftmost pixel in bit 4.
+const unsigned char FONT[36][7] = {
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E},
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C},
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F},
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F},
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C},
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F},
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11},
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10},
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D},
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11},
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E},
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04},
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A},
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11},
+    {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04},
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}
+};
+
+const int GLYPH_WIDTH = 5;
+const int GLYPH_HEIGHT = 7;
+
+uint64_t mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * SplitMix64 generator, whose sequence does not depend on the standard
+ * library implementation.
+ */
+class Random
+{
+public:
+    explicit Random(uint64_t seed) : _state(seed) {}
+
+    uint64_t next()
+    {
+        _state += 0x9e3779b97f4a7c15ULL;
+        return mix(_state);
+    }
+
+    // Return value in [0, 1).
+    float uniform() { return (float) (next() >> 40) / 16777216.0f; }
+
+    // Return value in [minimum, maximum).
+    float uniform(float minimum, float maximum) {
+        return minimum + (maximum - minimum) * uniform();
+    }
+
+    // Return integer in [minimum, maximum).
+    int range(int minimum, int maximum) {
+        return minimum + (int) (next() % (uint64_t) (maximum - minimum));
+    }
+
+private:
+    uint64_t _state;
+};
+
+struct Color
+{
+    float red;
+    float green;
+    float blue;
+};
+
+Color random_color(Random& random)
+{
+    Color color;
+    color.red = random.uniform();
+    color.green = random.uniform();
+    color.blue = random.uniform();
+    return color;
+}
+
+/**
+ * Output with pixel writes clipped to its bounds.
+ */
+class Canvas
+{
+public:
+    explicit Canvas(const Nuke::OutputView& output)
+        : _output(output)
+        , _components(std::min(output.components, 4))
+    {}
+
+    int width() const { return _output.width; }
+    int height() const { return _output.height; }
+
+    void set(int x, int y, float red, float green, float blue)
+    {
+        if (x < 0 || y < 0 || x >= _output.width || y >= _output.height) {
+            return;
+        }
+
+        const float values[4] = {red, green, blue, 1.0f};
+        switch (_output.type) {
+            case Nuke::PIXEL_UINT8:
+                write<uint8_t>(x, y, values);
+                break;
+            case Nuke::PIXEL_UINT16:
+                write<uint16_t>(x, y, values);
+                break;
+            case Nuke::PIXEL_HALF:
+                write<Nuke::Half>(x, y, values);
+                break;
+            case Nuke::PIXEL_FLOAT:
+                write<float>(x, y, values);
+                break;
+        }
+    }
+
+    void set(int x, int y, const Color& color)
+    {
+        set(x, y, color.red, color.green, color.blue);
+    }
+
+private:
+    template<typename T>
+    void write(int x, int y, const float* values)
+    {
+        T* pixel = _output.as<T>().pixel(x, y);
+        for (int component = 0; component < _components; component++) {
+            pixel[component * _output.channel_stride] = (
+                Nuke::PixelTraits<T>::from_float(values[component])
+            );
+        }
+    }
+
+    Nuke::OutputView _output;
+    int _components;
+};
+
+struct Point
+{
+    float x;
+    float y;
+};
+
+// Return monotonic value of the angle of vector in [0, 4), without
+// trigonometric functions.
+float pseudo_angle(float x, float y)
+{
+    const float sum = std::fabs(x) + std::fabs(y);
+    if (sum == 0.0f) {
+        return 0.0f;
+    }
+
+    const float ratio = x / sum;
+    return y >= 0.0f ? 1.0f - ratio : 3.0f + ratio;
+}
+
+void draw_gradient(
+    Canvas& canvas, Random& random, const Nuke::SceneParameters& parameters
+)
+{
+    const Color start = random_color(random);
+    const float direction_x = random.uniform(-1.0f, 1.0f);
+    const float direction_y = random.uniform(-1.0f, 1.0f);
+
+    const float norm = (
+        (std::fabs(direction_x) + std::fabs(direction_y) + 1e-6f)
+        * std::max(canvas.width(), canvas.height())
+    );
+
+    for (int y = 0; y < canvas.height(); y++) {
+        for (int x = 0; x < canvas.width(); x++) {
+            const float offset = (
+                (x - canvas.width() * 0.5f) * direction_x
+                + (y - canvas.height() * 0.5f) * direction_y
+            ) / norm * parameters.gradient;
+
+            canvas.set(
+                x, y, start.red + offset, start.green + offset,
+                start.blue + offset
+            );
+        }
+    }
+}
+
+void draw_texture_patch(
+    Canvas& canvas, Random& random, const Nuke::SceneParameters& parameters
+)
+{
+    const int size = std::min(canvas.width(), canvas.height());
+    const int width = random.range(size / 16 + 1, size / 4 + 2);
+    const int height = random.range(size / 16 + 1, size / 4 + 2);
+    const int x0 = random.range(-width / 2, canvas.width());
+    const int y0 = random.range(-height / 2, canvas.height());
+
+    const Color base = random_color(random);
+    const uint64_t seed = random.next();
+
+    const int x_end = std::min(x0 + width, canvas.width());
+    const int y_end = std::min(y0 + height, canvas.height());
+
+    for (int y = std::max(y0, 0); y < y_end; y++) {
+        for (int x = std::max(x0, 0); x < x_end; x++) {
+            const uint64_t hash = mix(
+                seed ^ ((uint64_t) (uint32_t) y << 32) ^ (uint32_t) x
+            );
+            const float noise = (
+                ((float) (hash >> 40) / 16777216.0f - 0.5f)
+                * parameters.texture_amplitude
+            );
+
+            canvas.set(
+                x, y, base.red + noise, base.green + noise, base.blue + noise
+            );
+        }
+    }
+}
+
+// Fill pixels whose center is inside polygon, with even-odd rule.
+void fill_polygon(
+    Canvas& canvas, const std::vector<Point>& points, const Color& color
+)
+{
+    float top = points[0].y;
+    float bottom = points[0].y;
+    for (size_t index = 1; index < points.size(); index++) {
+        top = std::min(top, points[index].y);
+        bottom = std::max(bottom, points[index].y);
+    }
+
+    std::vector<float> crossings;
+
+    const int y_start = std::max((int) std::floor(top), 0);
+    const int y_end = std::min((int) std::ceil(bottom), canvas.height());
+
+    for (int y = y_start; y < y_end; y++) {
+        const float center = y + 0.5f;
+        crossings.clear();
+
+        for (size_t index = 0; index < points.size(); index++) {
+            const Point& a = points[index];
+            const Point& b = points[(index + 1) % points.size()];
+
+            if ((a.y <= center) != (b.y <= center)) {
+                crossings.push_back(
+                    a.x + (center - a.y) * (b.x - a.x) / (b.y - a.y)
+                );
+            }
+        }
+
+        std::sort(crossings.begin(), crossings.end());
+
+        for (size_t index = 0; index + 1 < crossings.size(); index += 2) {
+            const int x_start = std::max(
+                (int) std::ceil(crossings[index] - 0.5f), 0
+            );
+            const int x_end = std::min(
+                (int) std::ceil(crossings[index + 1] - 0.5f), canvas.width()
+            );
+
+            for (int x = x_start; x < x_end; x++) {
+                canvas.set(x, y, color);
+            }
+        }
+    }
+}
+
+void draw_polygon(
+    Canvas& canvas, Random& random, const Nuke::SceneParameters& parameters
+)
+{
+    const float size = (float) std::min(canvas.width(), canvas.height());
+    const float radius = random.uniform(0.05f, 0.25f) * size;
+    const float center_x = random.uniform() * canvas.width();
+    const float center_y = random.uniform() * canvas.height();
+    const Color color = random_color(random);
+
+    std::vector<Point> points;
+
+    if (random.uniform() >= parameters.diagonal_ratio) {
+        // Rectangle aligned with axes.
+        const float half_width = radius;
+        const float half_height = radius * random.uniform(0.3f, 1.0f);
+
+        const Point corners[4] = {
+            {center_x - half_width, center_y - half_height},
+            {center_x + half_width, center_y - half_height},
+            {center_x + half_width, center_y + half_height},
+            {center_x - half_width, center_y + half_height}
+        };
+        points.assign(corners, corners + 4);
+    }
+    else {
+        // Vertices sorted by angle around center form a simple polygon.
+        const int count = random.range(3, 9);
+        std::vector<std::pair<float, Point> > vertices;
+
+        for (int index = 0; index < count; index++) {
+            const float x = random.uniform(-1.0f, 1.0f) * radius;
+            const float y = random.uniform(-1.0f, 1.0f) * radius;
+            const Point point = {center_x + x, center_y + y};
+            vertices.push_back(std::make_pair(pseudo_angle(x, y), point));
+        }
+
+        std::sort(
+            vertices.begin(), vertices.end(),
+            [](const std::pair<float, Point>& a,
+               const std::pair<float, Point>& b) {
+                return a.first < b.first;
+            }
+        );
+
+        for (size_t index = 0; index < vertices.size(); index++) {
+            points.push_back(vertices[index].second);
+        }
+    }
+
+    fill_polygon(canvas, points, color);
+}
+
+void draw_line(
+    Canvas& canvas, Random& random, const Nuke::SceneParameters& parameters
+)
+{
+    const float size = (float) std::max(canvas.width(), canvas.height());
+    const float length = random.uniform(0.05f, 0.5f) * size;
+    const float x0 = random.uniform() * canvas.width();
+    const float y0 = random.uniform() * canvas.height();
+    const Color color = random_color(random);
+
+    float dx = random.uniform(-1.0f, 1.0f);
+    float dy = random.uniform(-1.0f, 1.0f);
+
+    if (random.uniform() >= parameters.diagonal_ratio) {
+        // Horizontal or vertical line.
+        if (std::fabs(dx) > std::fabs(dy)) {
+            dy = 0.0f;
+        }
+        else {
+            dx = 0.0f;
+        }
+    }
+
+    const float norm = std::max(std::fabs(dx), std::fabs(dy)) + 1e-6f;
+    const int steps = (int) length;
+    const int width = std::max(parameters.line_width, 1);
+
+    // Step along major axis, one pixel at a time.
+    for (int step = 0; step <= steps; step++) {
+        const int x = (int) std::floor(x0 + dx / norm * step);
+        const int y = (int) std::floor(y0 + dy / norm * step);
+
+        for (int offset_y = 0; offset_y < width; offset_y++) {
+            for (int offset_x = 0; offset_x < width; offset_x++) {
+                canvas.set(
+                    x + offset_x - width / 2, y + offset_y - width / 2, color
+                );
+            }
+        }
+    }
+}
+
+void draw_text(
+    Canvas& canvas, Random& random, const Nuke::SceneParameters& parameters
+)
+{
+    const int scale = std::max(parameters.text_scale, 1);
+    const int length = random.range(4, 17);
+    const int x0 = random.range(0, canvas.width());
+    const int y0 = random.range(0, canvas.height());
+    const Color color = random_color(random);
+
+    for (int character = 0; character < length; character++) {
+        const unsigned char* glyph = FONT[random.range(0, 36)];
+        const int glyph_x = x0 + character * (GLYPH_WIDTH + 1) * scale;
+
+        for (int row = 0; row < GLYPH_HEIGHT * scale; row++) {
+            for (int column = 0; column < GLYPH_WIDTH * scale; column++) {
+                const int bit = GLYPH_WIDTH - 1 - column / scale;
+                if ((glyph[row / scale] >> bit) & 1) {
+                    canvas.set(glyph_x + column, y0 + row, color);
+                }
+            }
+        }
+    }
+}
+
+// Count run of length, and whether it is short.
+void add_run(long long& runs, long long& short_runs, int length)
+{
+    if (length > 0) {
+        runs++;
+        short_runs += length <= 2;
+    }
+}
+
+} // namespace
+
+
+namespace Nuke {
+
+double EdgeStatistics::density() const
+{
+    return pixels > 0 ? (double) edge_pixels / pixels : 0.0;
+}
+
+double EdgeStatistics::mean_horizontal_run() const
+{
+    return horizontal_runs > 0 ?
+        (double) horizontal_edges / horizontal_runs : 0.0;
+}
+
+double EdgeStatistics::mean_vertical_run() const
+{
+    return vertical_runs > 0 ? (double) vertical_edges / vertical_runs : 0.0;
+}
+
+double EdgeStatistics::short_run_ratio() const
+{
+    const long long runs = horizontal_runs + vertical_runs;
+    return runs > 0 ? (double) short_runs / runs : 0.0;
+}
+
+void generate_scene(
+    const SceneParameters& parameters, const OutputView& output
+)
+{
+    Canvas canvas(output);
+    Random random(mix(parameters.seed));
+
+    // Draw layers from the background to the foreground.
+    draw_gradient(canvas, random, parameters);
+
+    for (int index = 0; index < parameters.texture_patches; index++) {
+        draw_texture_patch(canvas, random, parameters);
+    }
+
+    for (int index = 0; index < parameters.polygons; index++) {
+        draw_polygon(canvas, random, parameters);
+    }
+
+    for (int index = 0; index < parameters.lines; index++) {
+        draw_line(canvas, random, parameters);
+    }
+
+    for (int index = 0; index < parameters.text; index++) {
+        draw_text(canvas, random, parameters);
+    }
+}
+
+EdgeStatistics edge_statistics(const EdgeBitmap& edges)
+{
+    EdgeStatistics statistics;
+    statistics.pixels = (long long) edges.width() * edges.height();
+
+    // Length of current vertical run of each column.
+    std::vector<int> vertical_runs(edges.width(), 0);
+
+    for (int y = 0; y < edges.height(); y++) {
+        const uint64_t* left_row = edges.left_row(y);
+        const uint64_t* top_row = edges.top_row(y);
+
+        int horizontal_run = 0;
+
+        for (int x = 0; x < edges.width(); x++) {
+            const int left = (int) ((left_row[x >> 6] >> (x & 63)) & 1);
+            const int top = (int) ((top_row[x >> 6] >> (x & 63)) & 1);
+
+            statistics.edge_pixels += left | top;
+            statistics.horizontal_edges += top;
+            statistics.vertical_edges += left;
+
+            if (top) {
+                horizontal_run++;
+            }
+            else {
+                add_run(
+                    statistics.horizontal_runs, statistics.short_runs,
+                    horizontal_run
+                );
+                horizontal_run = 0;
+            }
+
+            if (left) {
+                vertical_runs[x]++;
+            }
+            else {
+                add_run(
+                    statistics.vertical_runs, statistics.short_runs,
+                    vertical_runs[x]
+                );
+                vertical_runs[x] = 0;
+            }
+        }
+
+        add_run(
+            statistics.horizontal_runs, statistics.short_runs, horizontal_run
+        );
+    }
+
+    for (int x = 0; x < edges.width(); x++) {
+        add_run(
+            statistics.vertical_runs, statistics.short_runs, vertical_runs[x]
+        );
+    }
+
+    return statistics;
+}
+
+EdgeStatistics measure_edges(const InputView& input)
+{
+    NativePipeline pipeline;
+    pipeline.resize(input.width, input.height, input.width, input.height);
+
+    // Only luma and edges stages are needed, which do not write output.
+    pipeline.run_stage(NativePipeline::LUMA, 0, input, OutputView());
+    pipeline.run_stage(NativePipeline::EDGES, 0, input, OutputView());
+
+    return edge_statistics(pipeline.edges());
+}
+
+} // namespace Nuke
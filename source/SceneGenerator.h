@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_SCENE_GENERATOR_H
+#define SMAA_NUKE_SCENE_GENERATOR_H
+
+#include "EdgeBitmap.h"
+#include "NativePipeline.h"
+
+
+namespace Nuke {
+
+/**
+ * Geometry of a synthetic scene.
+ *
+ * Scenes are drawn without anti-aliasing, from a random generator which
+ * only depends on the seed, so that the same parameters always give the
+ * same scene. Sizes are relative to the frame, so that edge density does
+ * not depend much on resolution.
+ */
+struct SceneParameters
+{
+    SceneParameters()
+        : seed(1)
+        , polygons(12)
+        , lines(24)
+        , line_width(1)
+        , text(6)
+        , text_scale(2)
+        , texture_patches(2)
+        , texture_amplitude(0.3f)
+        , gradient(0.5f)
+        , diagonal_ratio(0.75f)
+    {}
+
+    unsigned int seed;
+
+    // Number of filled polygons.
+    int polygons;
+
+    // Number of lines, and their width in pixels.
+    int lines;
+    int line_width;
+
+    // Number of strings drawn with a 5x7 pixel font, scaled by an integer
+    // factor.
+    int text;
+    int text_scale;
+
+    // Number of rectangles filled with per-pixel noise of amplitude.
+    int texture_patches;
+    float texture_amplitude;
+
+    // Difference between both ends of the background gradient.
+    float gradient;
+
+    // Fraction of polygons and lines drawn at any angle, the others being
+    // aligned with the axes.
+    float diagonal_ratio;
+};
+
+/**
+ * Edges found in an image, which drive the cost of blending weights.
+ */
+struct EdgeStatistics
+{
+    EdgeStatistics()
+        : pixels(0), edge_pixels(0), horizontal_edges(0), vertical_edges(0)
+        , horizontal_runs(0), vertical_runs(0), short_runs(0)
+    {}
+
+    // Fraction of pixels with any edge.
+    double density() const;
+
+    // Mean length of runs of consecutive top edges along rows, and of left
+    // edges along columns, which bound search distances.
+    double mean_horizontal_run() const;
+    double mean_vertical_run() const;
+
+    // Fraction of runs of one or two pixels, mostly found on diagonal
+    // edges.
+    double short_run_ratio() const;
+
+    long long pixels;
+    long long edge_pixels;
+    long long horizontal_edges;
+    long long vertical_edges;
+    long long horizontal_runs;
+    long long vertical_runs;
+    long long short_runs;
+};
+
+// Draw scene into output, filling up to four components as RGBA.
+void generate_scene(
+    const SceneParameters& parameters, const OutputView& output
+);
+
+// Compute statistics of edges from bitmap.
+EdgeStatistics edge_statistics(const EdgeBitmap& edges);
+
+// Detect edges of input as the native pipeline does, and return their
+// statistics.
+EdgeStatistics measure_edges(const InputView& input);
+
+} // namespace Nuke
+
+#endif
@@ -0,0 +1,394 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ * Adapted from:
+ *
+ * Jorge Jimenez et al. (2013). Enhanced Subpixel Morphological Antialiasing.
+ * http://www.iryoku.com/smaa/
+ */
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Simd.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SMAA_SIMD_X64
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(SMAA_SIMD_X64)
+#include <intrin.h>
+#endif
+
+// Functions using AVX2 are compiled for it individually, so that the rest
+// of the library still runs on any x86-64 processor.
+#if defined(SMAA_SIMD_X64) && (defined(__GNUC__) || defined(__clang__))
+#define SMAA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SMAA_TARGET_AVX2
+#endif
+
+
+namespace {
+
+#if defined(SMAA_SIMD_X64)
+
+bool cpu_supports_avx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+
+    // AVX registers must also be saved by the operating system.
+    const bool os_saves_avx = (info[2] & (1 << 27)) != 0;
+    if (!os_saves_avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+// Load weight component of 8 consecutive pixels, normalized as by
+// NativePipeline::weight.
+SMAA_TARGET_AVX2
+inline __m256 load_weights(
+    const void* weights, Nuke::NativePipeline::WeightPrecision precision,
+    int component
+)
+{
+    const __m256i pixels = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    switch (precision) {
+        case Nuke::NativePipeline::WEIGHTS_UNORM8: {
+            // Each pixel holds its four weights in 32 bits.
+            const __m256i words = _mm256_loadu_si256(
+                (const __m256i*) weights
+            );
+            const __m256i values = _mm256_and_si256(
+                _mm256_srl_epi32(words, _mm_cvtsi32_si128(component * 8)),
+                _mm256_set1_epi32(0xff)
+            );
+            return _mm256_mul_ps(
+                _mm256_cvtepi32_ps(values), _mm256_set1_ps(1.0f / 255.0f)
+            );
+        }
+        case Nuke::NativePipeline::WEIGHTS_UNORM16: {
+            // Each pixel holds its four weights in two 32-bit words.
+            const __m256i words = _mm256_i32gather_epi32(
+                (const int*) weights,
+                _mm256_add_epi32(
+                    _mm256_slli_epi32(pixels, 1),
+                    _mm256_set1_epi32(component >> 1)
+                ),
+                4
+            );
+            const __m256i values = _mm256_and_si256(
+                _mm256_srl_epi32(
+                    words, _mm_cvtsi32_si128((component & 1) * 16)
+                ),
+                _mm256_set1_epi32(0xffff)
+            );
+            return _mm256_mul_ps(
+                _mm256_cvtepi32_ps(values),
+                _mm256_set1_ps(1.0f / 65535.0f)
+            );
+        }
+        case Nuke::NativePipeline::WEIGHTS_FLOAT:
+            break;
+    }
+
+    return _mm256_i32gather_ps(
+        (const float*) weights + component, _mm256_slli_epi32(pixels, 2), 4
+    );
+}
+
+// Clamp integers between low and high, per lane.
+SMAA_TARGET_AVX2
+inline __m256i clamp(__m256i values, __m256i low, __m256i high)
+{
+    return _mm256_min_epi32(_mm256_max_epi32(values, low), high);
+}
+
+// Add samples of input interpolated between the two pixels around
+// positions offset from 8 pixels along one axis, horizontal or vertical
+// per lane, multiplied by weights, to color components, in the same order
+// of operations as the scalar pipeline.
+SMAA_TARGET_AVX2
+inline void sample_input(
+    const Nuke::ImageView<const float>& input, __m256i x, __m256i y,
+    __m256 horizontal, __m256 offset, __m256 weight, int components,
+    __m256* color
+)
+{
+    const __m256i h = _mm256_castps_si256(horizontal);
+
+    const __m256 position = _mm256_add_ps(
+        _mm256_cvtepi32_ps(_mm256_blendv_epi8(y, x, h)), offset
+    );
+    const __m256 floor_position = _mm256_floor_ps(position);
+    const __m256 alpha = _mm256_sub_ps(position, floor_position);
+
+    const __m256i first = _mm256_cvttps_epi32(floor_position);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i last = _mm256_blendv_epi8(
+        _mm256_set1_epi32(input.height - 1),
+        _mm256_set1_epi32(input.width - 1), h
+    );
+
+    const __m256i p0 = clamp(first, zero, last);
+    const __m256i p1 = clamp(
+        _mm256_add_epi32(first, _mm256_set1_epi32(1)), zero, last
+    );
+
+    // Offsets of the two pixels sampled, in values.
+    const __m256i pixel_stride = _mm256_set1_epi32((int) input.pixel_stride);
+    const __m256i row_stride = _mm256_set1_epi32((int) input.row_stride);
+
+    const __m256i o0 = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_blendv_epi8(p0, y, h), row_stride),
+        _mm256_mullo_epi32(_mm256_blendv_epi8(x, p0, h), pixel_stride)
+    );
+    const __m256i o1 = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_blendv_epi8(p1, y, h), row_stride),
+        _mm256_mullo_epi32(_mm256_blendv_epi8(x, p1, h), pixel_stride)
+    );
+
+    for (int c = 0; c < components; c++) {
+        const float* plane = input.data + c * input.channel_stride;
+
+        const __m256 v0 = _mm256_i32gather_ps(plane, o0, 4);
+        const __m256 v1 = _mm256_i32gather_ps(plane, o1, 4);
+        const __m256 value = _mm256_add_ps(
+            v0, _mm256_mul_ps(_mm256_sub_ps(v1, v0), alpha)
+        );
+
+        color[c] = _mm256_add_ps(color[c], _mm256_mul_ps(weight, value));
+    }
+}
+
+// Store 8 values, bypassing caches when destination is aligned.
+SMAA_TARGET_AVX2
+inline void store_values(float* destination, __m256 values)
+{
+    if (((uintptr_t) destination & 31) == 0) {
+        _mm256_stream_ps(destination, values);
+    }
+    else {
+        _mm256_storeu_ps(destination, values);
+    }
+}
+
+// Copies shorter than this are not worth streaming.
+const size_t STREAM_MINIMUM_BYTES = 128;
+
+#endif
+
+} // namespace
+
+
+namespace Nuke {
+
+bool simd_available()
+{
+#if defined(SMAA_SIMD_X64)
+    static const bool available = []() {
+        const char* enabled = std::getenv("SMAA_SIMD");
+        if (enabled && std::string(enabled) == "0") {
+            return false;
+        }
+        return cpu_supports_avx2();
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+SMAA_TARGET_AVX2
+void stream_copy(void* destination, const void* source, size_t bytes)
+{
+#if defined(SMAA_SIMD_X64)
+    char* target = (char*) destination;
+    const char* origin = (const char*) source;
+
+    if (bytes < STREAM_MINIMUM_BYTES) {
+        std::memcpy(target, origin, bytes);
+        return;
+    }
+
+    // Copy up to the first byte of destination aligned on 32 bytes.
+    const size_t head = (32 - ((uintptr_t) target & 31)) & 31;
+    std::memcpy(target, origin, head);
+    target += head;
+    origin += head;
+    bytes -= head;
+
+    for (; bytes >= 32; bytes -= 32, target += 32, origin += 32) {
+        _mm256_stream_si256(
+            (__m256i*) target,
+            _mm256_loadu_si256((const __m256i*) origin)
+        );
+    }
+
+    std::memcpy(target, origin, bytes);
+#else
+    std::memcpy(destination, source, bytes);
+#endif
+}
+
+void stream_fence()
+{
+#if defined(SMAA_SIMD_X64)
+    _mm_sfence();
+#endif
+}
+
+SMAA_TARGET_AVX2
+void blend_group_avx2(
+    const ImageView<const float>& input, const ImageView<float>& output,
+    int x, int y, const GroupWeights& weights
+)
+{
+#if defined(SMAA_SIMD_X64)
+    const int components = std::min(output.components, 4);
+
+    // Fetch the blending weights of the 8 pixels.
+    const __m256 a[4] = {
+        load_weights(weights.right, weights.precision, 3),
+        load_weights(weights.bottom, weights.precision, 1),
+        load_weights(weights.current, weights.precision, 2),
+        load_weights(weights.current, weights.precision, 0)
+    };
+
+    const __m256 sum = _mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(a[0], a[1]), a[2]), a[3]
+    );
+    const __m256 untouched = _mm256_cmp_ps(
+        sum, _mm256_set1_ps(0.01f), _CMP_LT_OQ
+    );
+
+    // Pick horizontal or vertical blending for each pixel.
+    const __m256 h = _mm256_cmp_ps(
+        _mm256_max_ps(a[0], a[2]), _mm256_max_ps(a[1], a[3]), _CMP_GT_OQ
+    );
+    // Pixels are blended with the pixels on both sides along one axis.
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 offset[2] = {
+        _mm256_blendv_ps(a[1], a[0], h),
+        _mm256_xor_ps(_mm256_blendv_ps(a[3], a[2], h), sign)
+    };
+
+    __m256 weight[2] = {
+        _mm256_blendv_ps(a[1], a[0], h),
+        _mm256_blendv_ps(a[3], a[2], h)
+    };
+
+    // Pixels left untouched may divide by zero, but are discarded.
+    const __m256 weight_sum = _mm256_add_ps(weight[0], weight[1]);
+    weight[0] = _mm256_div_ps(weight[0], weight_sum);
+    weight[1] = _mm256_div_ps(weight[1], weight_sum);
+
+    const __m256i position_x = _mm256_add_epi32(
+        _mm256_set1_epi32(x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+    );
+    const __m256i position_y = _mm256_set1_epi32(y);
+
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 color[4] = {zero, zero, zero, zero};
+    sample_input(
+        input, position_x, position_y, h, offset[0], weight[0], components,
+        color
+    );
+    sample_input(
+        input, position_x, position_y, h, offset[1], weight[1], components,
+        color
+    );
+
+    // Copy input on pixels left untouched.
+    const __m256i pixels = _mm256_mullo_epi32(
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+        _mm256_set1_epi32((int) input.pixel_stride)
+    );
+    const float* source = input.pixel(x, y);
+
+    for (int c = 0; c < components; c++) {
+        color[c] = _mm256_blendv_ps(
+            color[c],
+            _mm256_i32gather_ps(source + c * input.channel_stride, pixels, 4),
+            untouched
+        );
+    }
+
+    float* destination = output.pixel(x, y);
+
+    if (output.pixel_stride == 1) {
+        for (int c = 0; c < components; c++) {
+            store_values(destination + c * output.channel_stride, color[c]);
+        }
+    }
+    else if (
+        components == 4 && output.pixel_stride == 4
+        && output.channel_stride == 1
+    ) {
+        // Transpose components into interleaved pixels, pixels n and n + 4
+        // being gathered in the lower and upper halves of each vector, then
+        // store two consecutive pixels at a time.
+        const __m256 rg_low = _mm256_unpacklo_ps(color[0], color[1]);
+        const __m256 rg_high = _mm256_unpackhi_ps(color[0], color[1]);
+        const __m256 ba_low = _mm256_unpacklo_ps(color[2], color[3]);
+        const __m256 ba_high = _mm256_unpackhi_ps(color[2], color[3]);
+
+        const __m256 pixels04 = _mm256_shuffle_ps(rg_low, ba_low, 0x44);
+        const __m256 pixels15 = _mm256_shuffle_ps(rg_low, ba_low, 0xee);
+        const __m256 pixels26 = _mm256_shuffle_ps(rg_high, ba_high, 0x44);
+        const __m256 pixels37 = _mm256_shuffle_ps(rg_high, ba_high, 0xee);
+
+        store_values(
+            destination, _mm256_permute2f128_ps(pixels04, pixels15, 0x20)
+        );
+        store_values(
+            destination + 8,
+            _mm256_permute2f128_ps(pixels26, pixels37, 0x20)
+        );
+        store_values(
+            destination + 16,
+            _mm256_permute2f128_ps(pixels04, pixels15, 0x31)
+        );
+        store_values(
+            destination + 24,
+            _mm256_permute2f128_ps(pixels26, pixels37, 0x31)
+        );
+    }
+    else {
+        float values[8];
+        for (int c = 0; c < components; c++) {
+            _mm256_storeu_ps(values, color[c]);
+            for (int pixel = 0; pixel < 8; pixel++) {
+                destination[
+                    pixel * output.pixel_stride + c * output.channel_stride
+                ] = values[pixel];
+            }
+        }
+    }
+#else
+    (void) input;
+    (void) output;
+    (void) x;
+    (void) y;
+    (void) weights;
+#endif
+}
+
+} // namespace Nuke
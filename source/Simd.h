@@ -0,0 +1,57 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_SIMD_H
+#define SMAA_NUKE_SIMD_H
+
+#include <cstddef>
+
+#include "NativePipeline.h"
+
+
+namespace Nuke {
+
+/**
+ * Blending weights read by a group of 8 pixels, as stored by the native
+ * pipeline.
+ */
+struct GroupWeights
+{
+    // Weights of the first pixel of the group, of the pixel at its right,
+    // and of the pixel below it.
+    const void* current;
+    const void* right;
+    const void* bottom;
+
+    NativePipeline::WeightPrecision precision;
+};
+
+// Return whether code paths using AVX2 are run, which is when the processor
+// supports it and SMAA_SIMD is not set to 0. Always false on processors
+// other than x86-64.
+bool simd_available();
+
+// Copy bytes with streaming stores, so that the destination does not evict
+// data still to be read from cache. Only valid when SIMD is available.
+void stream_copy(void* destination, const void* source, size_t bytes);
+
+// Make streaming stores visible before stores which follow.
+void stream_fence();
+
+// Blend group of 8 pixels from x along row of float images with AVX2,
+// copying pixels whose weights are below threshold, and write them with
+// streaming stores when possible. Pixel at x + 8 must be within the image,
+// and offsets of all pixels must fit in 32-bit integers. Only valid when
+// SIMD is available.
+void blend_group_avx2(
+    const ImageView<const float>& input, const ImageView<float>& output,
+    int x, int y, const GroupWeights& weights
+);
+
+} // namespace Nuke
+
+#endif
@@ -5,21 +5,31 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <future>
+#include <iostream>
 #include <string>
 #include <sstream>
+#include <system_error>
 #include <vector>
 
 #include "DDImage/PlanarIop.h"
 #include "DDImage/Knobs.h"
 #include "DDImage/Channel.h"
 #include "DDImage/Blink.h"
+#include "DDImage/MetaData.h"
 
 #include "Blink/Blink.h"
 
 #include "Smaa.h"
-#include "AreaTex.h"
-#include "SearchTex.h"
+#include "Autotune.h"
+#include "Trace.h"
+#include "AreaTable.h"
+#include "SearchTable.h"
 
+#include "SMAALuma.h"
 #include "SMAALumaEdges.h"
 #include "SMAABlend.h"
 #include "SMAANeighborhood.h"
@@ -27,6 +37,51 @@
 static const char* const CLASS = "Smaa";
 static const char* const HELP = "Subpixel Morphological Anti-Aliasing";
 
+// Labels of blending weight storage, in the order of
+// NativePipeline::WeightPrecision.
+static const char* const WEIGHT_PRECISIONS[] = {
+    "8-bit", "16-bit", "float", 0
+};
+
+// Metadata keys of peak memory of the current frame and of its stripes.
+static const char* const FRAME_MEMORY_KEY = "smaa/peak_frame_bytes";
+static const char* const STRIPE_MEMORY_KEY = "smaa/peak_stripe_bytes";
+
+// Return whether peak memory is logged, when the SMAA_LOG_MEMORY
+// environment variable is set to 1.
+static bool log_memory()
+{
+    static const bool enabled = (
+        std::getenv("SMAA_LOG_MEMORY")
+        && std::string(std::getenv("SMAA_LOG_MEMORY")) == "1"
+    );
+    return enabled;
+}
+
+// Return bytes of float image covering box.
+static long long image_bytes(const DD::Image::Box& box, int components)
+{
+    return (long long) box.w() * box.h() * components * sizeof(float);
+}
+
+static long long plane_bytes(const DD::Image::ImagePlane& plane)
+{
+    return image_bytes(plane.bounds(), plane.nComps());
+}
+
+static double megabytes(long long bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+// Return key of warm-up of device for input with components.
+static std::string warm_up_key(
+    const Blink::ComputeDevice& device, int components
+)
+{
+    return device.name() + ":" + std::to_string(components);
+}
+
 static DD::Image::Iop* build(Node *node) {
     return new Nuke::Smaa(node);
 }
@@ -37,6 +92,14 @@ const DD::Image::Iop::Description Nuke::Smaa::description(
 
 namespace Nuke {
 
+std::map<std::string, Smaa::Textures> Smaa::_textures;
+std::mutex Smaa::_textures_mutex;
+
+// Defined after textures, so that warm-ups still running are waited for
+// before textures are destroyed on exit.
+std::map<std::string, std::shared_future<void>> Smaa::_warm_ups;
+std::mutex Smaa::_warm_ups_mutex;
+
 const char* Smaa::Class() const { return CLASS; }
 const char* Smaa::node_help() const { return HELP; }
 
@@ -44,18 +107,18 @@ Smaa::Smaa(Node* node)
     : DD::Image::PlanarIop(node)
     , _gpu_device(Blink::ComputeDevice::CurrentGPUDevice())
     , _use_gpu_if_available(true)
+    , _use_native_cpu(false)
+    , _alpha_passthrough(false)
+    , _weight_precision(NativePipeline::WEIGHTS_FLOAT)
+    , _trace(false)
+    , _processed_channels(DD::Image::Mask_RGBA)
+    , _luma_program(SMAALuma)
     , _edges_program(SMAALumaEdges)
     , _blend_program(SMAABlend)
     , _neighborhood_program(SMAANeighborhood)
+    , _memory_frame(0.0)
+    , _memory_frame_started(false)
 {
-    convert_texture(
-        searchTexBytes, _search_texture,
-        SEARCHTEX_WIDTH, SEARCHTEX_HEIGHT, 1
-    );
-    convert_texture(
-        areaTexBytes, _area_texture,
-        AREATEX_WIDTH, AREATEX_HEIGHT, 2
-    );
 }
 
 void Smaa::knobs(DD::Image::Knob_Closure &f)
@@ -67,17 +130,64 @@ void Smaa::knobs(DD::Image::Knob_Closure &f)
     Named_Text_knob(f, "gpu_name", gpu_name.c_str());
     Newline(f);
     Bool_knob(f, &_use_gpu_if_available, "use_gpu", "Use GPU if available");
+    Newline(f);
+    Bool_knob(f, &_use_native_cpu, "use_native_cpu", "Use native CPU pipeline");
+    Tooltip(
+        f, "Process on CPU without Blink when GPU is not used, storing edges "
+        "as bitmasks to speed up pattern searches."
+    );
+    Enumeration_knob(
+        f, &_weight_precision, WEIGHT_PRECISIONS, "weight_precision",
+        "Weight precision"
+    );
+    Tooltip(
+        f, "Storage of blending weights of the native CPU pipeline. 8-bit "
+        "and 16-bit weights are faster on large images, but quantize "
+        "blending offsets, which slightly changes the result."
+    );
     Divider(f);
+    Bool_knob(f, &_alpha_passthrough, "alpha_passthrough", "Alpha passthrough");
+    Tooltip(
+        f, "Copy alpha straight through from input when it is the only "
+        "channel requested, instead of detecting edges on all channels."
+    );
+    Bool_knob(f, &_trace, "trace", "Trace timings");
+    Tooltip(
+        f, "Record timings of stripes and passes on all threads, and write "
+        "them as Chrome trace JSON after each stripe, to the file set by the "
+        "SMAA_TRACE environment variable or to smaa-trace-<pid>.json in the "
+        "current directory."
+    );
 }
 
 void Smaa::_validate(bool)
 {
+    if (_trace) {
+        enable_trace();
+    }
+
     // Copy bbox channels etc from input0, which will validate it.
     copy_info();
 
+    // Only process alpha channel if input provides it.
+    _processed_channels = DD::Image::Mask_RGB;
+    if (input0().info().channels().contains(DD::Image::Chan_Alpha)) {
+        _processed_channels += DD::Image::Mask_Alpha;
+    }
+    set_out_channels(_processed_channels);
+
     // Turn alpha channel on.
-    set_out_channels(DD::Image::Mask_RGBA);
     info_.turn_on(DD::Image::Mask_RGBA);
+
+    // Warm up the device used by Blink for processed channels, unless the
+    // native pipeline is used instead.
+    const bool using_gpu = _use_gpu_if_available && _gpu_device.available();
+    if (using_gpu || !_use_native_cpu) {
+        start_warm_up(
+            using_gpu ? _gpu_device : Blink::ComputeDevice::CurrentCPUDevice(),
+            _processed_channels.size()
+        );
+    }
 }
 
 void Smaa::getRequests(
@@ -90,7 +200,118 @@ void Smaa::getRequests(
     data.request(&input0(), box, channels, count);
 }
 
+const DD::Image::MetaData::Bundle& Smaa::_fetchMetaData(const char* key)
+{
+    // Metadata is fetched before the frame is rendered, so peaks are only
+    // known once it was rendered before.
+    MemoryPeaks peaks = {0, 0};
+
+    std::lock_guard<std::mutex> lock(_memory_mutex);
+    std::map<double, MemoryPeaks>::const_iterator it = _memory_peaks.find(
+        outputContext().frame()
+    );
+    if (it != _memory_peaks.end()) {
+        peaks = it->second;
+    }
+
+    _meta_data = input0().fetchMetaData(key);
+    _meta_data.setData(FRAME_MEMORY_KEY, (double) peaks.frame);
+    _meta_data.setData(STRIPE_MEMORY_KEY, (double) peaks.stripe);
+    return _meta_data;
+}
+
 void Smaa::renderStripe(DD::Image::ImagePlane &output_plane)
+{
+    TraceScope scope("renderStripe");
+
+    begin_frame_memory(outputContext().frame());
+
+    MemoryCounter memory(&_frame_memory);
+
+    // Exceptions such as failed allocations, including those thrown by
+    // native pipeline workers, are reported instead of ending the process.
+    try {
+        render_stripe(output_plane, memory);
+    }
+    catch (std::exception& e) {
+        std::string message = std::string("Render: ") + e.what();
+        error(message.c_str());
+    }
+
+    end_stripe_memory(output_plane, memory);
+
+    // Events are written as stripes are rendered, so that buffers are
+    // recycled and traces are kept if Nuke does not exit cleanly.
+    scope.stop();
+    flush_trace();
+}
+
+void Smaa::render_stripe(
+    DD::Image::ImagePlane &output_plane, MemoryCounter& memory
+)
+{
+    // Output plane is allocated by Nuke, but held for the whole stripe.
+    MemoryAllocation output_allocation(memory, plane_bytes(output_plane));
+
+    const DD::Image::ChannelSet requested = output_plane.channels();
+
+    DD::Image::ChannelSet processed = requested;
+    processed &= _processed_channels;
+
+    // Alpha alone can be copied straight through if requested.
+    if (_alpha_passthrough && processed == DD::Image::Mask_Alpha) {
+        processed = DD::Image::Mask_None;
+    }
+
+    // Nothing can be affected, copy input straight through.
+    if (processed.empty()) {
+        input0().fetchPlane(output_plane);
+        return;
+    }
+
+    // Process Nuke's plane directly if it only holds processed channels.
+    if (requested == _processed_channels) {
+        process_plane(output_plane, memory);
+        return;
+    }
+
+    // Otherwise, process all channels required to detect edges and only
+    // keep the requested ones.
+    DD::Image::ImagePlane plane(
+        output_plane.bounds(),
+        output_plane.packed(),
+        _processed_channels,
+        _processed_channels.size()
+    );
+    MemoryAllocation plane_allocation(memory, plane_bytes(plane));
+
+    process_plane(plane, memory);
+    output_plane.makeWritable();
+    copy_channels(plane, output_plane, processed);
+
+    // Copy channels which cannot be affected from input.
+    DD::Image::ChannelSet passthrough = requested;
+    passthrough -= processed;
+
+    if (!passthrough.empty()) {
+        DD::Image::ImagePlane passthrough_plane(
+            output_plane.bounds(),
+            output_plane.packed(),
+            passthrough,
+            passthrough.size()
+        );
+        MemoryAllocation passthrough_allocation(
+            memory, plane_bytes(passthrough_plane)
+        );
+
+        input0().fetchPlane(passthrough_plane);
+        copy_channels(passthrough_plane, output_plane, passthrough);
+    }
+}
+
+void Smaa::process_plane(
+    DD::Image::ImagePlane &output_plane, MemoryCounter& memory
+)
 {
     DD::Image::Box input_box = output_plane.bounds();
     input_box.intersect(input0().info());
@@ -102,10 +323,24 @@ void Smaa::renderStripe(DD::Image::ImagePlane &output_plane)
         output_plane.channels(),
         output_plane.nComps()
     );
+    MemoryAllocation input_allocation(memory, plane_bytes(input_plane));
 
     input0().fetchPlane(input_plane);
     output_plane.makeWritable();
 
+    bool using_gpu = _use_gpu_if_available && _gpu_device.available();
+
+    // Native pipeline handles interleaved and planar planes as they are,
+    // as long as they cover the same bounds.
+    const bool use_native = (
+        !using_gpu && _use_native_cpu && input_box == output_plane.bounds()
+    );
+
+    if (use_native) {
+        run_native_pipeline(input_plane, output_plane, memory);
+        return;
+    }
+
     // Wrap planes as Blink images.
     Blink::Image output_image;
     Blink::Image input_image;
@@ -120,28 +355,54 @@ void Smaa::renderStripe(DD::Image::ImagePlane &output_plane)
         return;
     }
 
-    bool using_gpu = _use_gpu_if_available && _gpu_device.available();
-
     // Get a reference to the ComputeDevice to do our processing on.
     Blink::ComputeDevice compute_device = using_gpu ?
         _gpu_device : Blink::ComputeDevice::CurrentCPUDevice();
 
-    // Distribute input image from the device used by Nuke to compute device.
+    // Kernels being compiled in background are not compiled twice.
+    wait_warm_up(compute_device, output_plane.nComps());
+
+    // Distribute input image from the device used by Nuke to compute device,
+    // which copies it on GPU.
     Blink::Image input = input_image.distributeTo(compute_device);
+    MemoryAllocation input_copy_allocation(
+        memory, using_gpu ? plane_bytes(input_plane) : 0
+    );
 
     // Bind compute device to the calling thread.
     Blink::ComputeDeviceBinder binder(compute_device);
 
+    // Intermediate results need four channels, so RGB planes cannot be used
+    // to store them.
+    const bool use_plane = !using_gpu && output_plane.nComps() == 4;
+
     // Make output images if GPU is being used, otherwise just use Nuke's planes.
-    Blink::Image edges_tex = using_gpu ?
-        output_image.makeLike(_gpu_device) : output_image;
-    Blink::Image blend_tex = using_gpu ?
-        output_image.makeLike(_gpu_device) : output_image;
+    Blink::Image edges_tex = use_plane ?
+        output_image : create_intermediate_image(compute_device, input_box);
+    Blink::Image blend_tex = use_plane ?
+        output_image : create_intermediate_image(compute_device, input_box);
     Blink::Image output = using_gpu ?
         output_image.makeLike(_gpu_device) : output_image;
 
+    // Luma is computed once per pixel, so that edge detection reads a
+    // single channel for the pixel and its six neighbors.
+    Blink::Image luma_tex = create_intermediate_image(
+        compute_device, input_box, 1
+    );
+
+    const long long intermediate_bytes = image_bytes(input_box, 4);
+    MemoryAllocation intermediates_allocation(
+        memory,
+        image_bytes(input_box, 1) + (use_plane ? 0 : 2 * intermediate_bytes)
+    );
+    MemoryAllocation output_copy_allocation(
+        memory, using_gpu ? plane_bytes(output_plane) : 0
+    );
+
     // Apply SMAA scripts.
-    run_edges_detection(compute_device, input, edges_tex);
+    run_luma(compute_device, input, luma_tex);
+
+    run_edges_detection(compute_device, luma_tex, edges_tex);
     run_blending_weight_calculation(compute_device, edges_tex, blend_tex);
     run_neighborhood_blending(compute_device, input, blend_tex, output);
 
@@ -151,20 +412,60 @@ void Smaa::renderStripe(DD::Image::ImagePlane &output_plane)
     }
 }
 
-void Smaa::run_edges_detection(
+void Smaa::run_luma(
     Blink::ComputeDevice device,
     const Blink::Image& input,
-    const Blink::Image& edges_tex
+    const Blink::Image& luma_tex
 )
 {
+    TraceScope scope("run_luma");
+
     std::vector<Blink::Image> images;
     images.push_back(input);
+    images.push_back(luma_tex);
+
+    try {
+        TraceScope construction("luma kernel construction");
+        Blink::Kernel luma_kernel(
+            _luma_program, device, images, kBlinkCodegenDefault
+        );
+        construction.stop();
+
+        luma_kernel.iterate();
+    }
+    catch (Blink::ParseException& e) {
+        std::ostringstream line_number;
+        line_number << e.lineNumber();
+        std::string message = (
+            "Luma (L" + line_number.str() + "): " + e.parseError()
+        );
+        error(message.c_str());
+    }
+    catch (Blink::Exception& e) {
+        std::string message = "Luma: " + e.userMessage();
+        error(message.c_str());
+    }
+}
+
+void Smaa::run_edges_detection(
+    Blink::ComputeDevice device,
+    const Blink::Image& luma_tex,
+    const Blink::Image& edges_tex
+)
+{
+    TraceScope scope("run_edges_detection");
+
+    std::vector<Blink::Image> images;
+    images.push_back(luma_tex);
     images.push_back(edges_tex);
 
     try {
+        TraceScope construction("edges kernel construction");
         Blink::Kernel edges_kernel(
             _edges_program, device, images, kBlinkCodegenDefault
         );
+        construction.stop();
+
         edges_kernel.iterate();
     }
     catch (Blink::ParseException& e) {
@@ -188,8 +489,11 @@ void Smaa::run_blending_weight_calculation(
     const Blink::Image& blend_tex
 )
 {
-    Blink::Image search_tex = create_search_texture(device);
-    Blink::Image area_tex = create_area_texture(device);
+    TraceScope scope("run_blending_weight_calculation");
+
+    Blink::Image search_tex;
+    Blink::Image area_tex;
+    fetch_textures(device, search_tex, area_tex);
 
     std::vector<Blink::Image> images;
     images.push_back(edges_tex);
@@ -198,9 +502,26 @@ void Smaa::run_blending_weight_calculation(
     images.push_back(blend_tex);
 
     try {
+        TraceScope construction("blend kernel construction");
         Blink::Kernel blend_kernel(
             _blend_program, device, images, kBlinkCodegenDefault
         );
+        construction.stop();
+
+        // Match the distances stored in area texture.
+        blend_kernel.setParamValue(
+            "max_search_steps", (float) SMAA_MAX_SEARCH_STEPS
+        );
+        blend_kernel.setParamValue(
+            "max_search_steps_diag", (float) SMAA_MAX_SEARCH_STEPS_DIAG
+        );
+        blend_kernel.setParamValue(
+            "max_distance", (float) AREATABLE_MAX_DISTANCE
+        );
+        blend_kernel.setParamValue(
+            "max_distance_diag", (float) AREATABLE_MAX_DISTANCE_DIAG
+        );
+
         blend_kernel.iterate();
     }
     catch (Blink::ParseException& e) {
@@ -225,15 +546,20 @@ void Smaa::run_neighborhood_blending(
     const Blink::Image& output
 )
 {
+    TraceScope scope("run_neighborhood_blending");
+
     std::vector<Blink::Image> images;
     images.push_back(input);
     images.push_back(blend_tex);
     images.push_back(output);
 
     try {
+        TraceScope construction("neighborhood kernel construction");
         Blink::Kernel neighborhood_kernel(
             _neighborhood_program, device, images, kBlinkCodegenDefault
         );
+        construction.stop();
+
         neighborhood_kernel.iterate();
     }
     catch (Blink::ParseException& e) {
@@ -251,45 +577,272 @@ void Smaa::run_neighborhood_blending(
     }
 }
 
+void Smaa::run_native_pipeline(
+    const DD::Image::ImagePlane& input_plane,
+    DD::Image::ImagePlane& output_plane,
+    MemoryCounter& memory
+)
+{
+    TraceScope scope("run_native_pipeline");
+
+    const DD::Image::Box& box = output_plane.bounds();
+
+    InputView input(
+        input_plane.readable(), box.w(), box.h(), input_plane.nComps(),
+        input_plane.colStride(), input_plane.rowStride(),
+        input_plane.chanStride()
+    );
+    OutputView output(
+        output_plane.writable(), box.w(), box.h(), output_plane.nComps(),
+        output_plane.colStride(), output_plane.rowStride(),
+        output_plane.chanStride()
+    );
+
+    // Tile size and number of threads tuned for the host, if any.
+    const TuningConfig tuning = host_tuning();
+    _native_pipeline.set_tile_size(tuning.tile_width, tuning.tile_height);
+    _native_pipeline.set_threads(tuning.threads);
+    _native_pipeline.set_weight_precision(
+        (NativePipeline::WeightPrecision) _weight_precision
+    );
+
+    _native_pipeline.process(input, output);
+
+    // Intermediates are kept for the next stripes, and only known once
+    // resized for this one, so they are added to the planes held at their
+    // peak.
+    MemoryAllocation intermediates_allocation(
+        memory, (long long) _native_pipeline.memory_usage()
+    );
+}
+
+void Smaa::begin_frame_memory(double frame)
+{
+    std::lock_guard<std::mutex> lock(_memory_mutex);
+    if (_memory_frame_started && frame == _memory_frame) {
+        return;
+    }
+
+    if (_memory_frame_started && log_memory()) {
+        const MemoryPeaks& peaks = _memory_peaks[_memory_frame];
+        std::cout << "Smaa: frame " << _memory_frame << " peak "
+                  << megabytes(peaks.frame) << " MB, stripe peak "
+                  << megabytes(peaks.stripe) << " MB" << std::endl;
+    }
+
+    // Peaks of a frame rendered again are replaced.
+    const MemoryPeaks peaks = {0, 0};
+    _memory_peaks[frame] = peaks;
+
+    _frame_memory.reset_peak();
+    _memory_frame = frame;
+    _memory_frame_started = true;
+}
+
+void Smaa::end_stripe_memory(
+    const DD::Image::ImagePlane& output_plane, const MemoryCounter& memory
+)
+{
+    std::lock_guard<std::mutex> lock(_memory_mutex);
+    MemoryPeaks& peaks = _memory_peaks[_memory_frame];
+    peaks.frame = std::max(peaks.frame, _frame_memory.peak());
+    peaks.stripe = std::max(peaks.stripe, memory.peak());
+
+    if (log_memory()) {
+        const DD::Image::Box& box = output_plane.bounds();
+        std::cout << "Smaa: frame " << _memory_frame << " stripe ["
+                  << box.y() << ", " << box.t() << ") peak "
+                  << megabytes(memory.peak()) << " MB" << std::endl;
+    }
+}
+
+void Smaa::copy_channels(
+    const DD::Image::ImagePlane& source,
+    DD::Image::ImagePlane& destination,
+    const DD::Image::ChannelSet& channels
+)
+{
+    const DD::Image::Box& box = destination.bounds();
+
+    foreach(channel, channels) {
+        const int source_index = source.chanNo(channel);
+        const int destination_index = destination.chanNo(channel);
+
+        for (int y = box.y(); y < box.t(); y++) {
+            for (int x = box.x(); x < box.r(); x++) {
+                destination.writableAt(x, y, destination_index) = (
+                    source.at(x, y, source_index)
+                );
+            }
+        }
+    }
+}
+
+Blink::Image Smaa::create_intermediate_image(
+    Blink::ComputeDevice device, const DD::Image::Box& box, int components
+)
+{
+    Blink::Rect rect(box.x(), box.y(), box.r(), box.t());
+    Blink::PixelInfo pixelInfo(components, kBlinkDataFloat);
+    Blink::ImageInfo imageInfo(rect, pixelInfo);
+    return Blink::Image(imageInfo, device);
+}
+
 Blink::Image Smaa::create_search_texture(Blink::ComputeDevice device) {
-    Blink::Rect rect(0, 0, SEARCHTEX_WIDTH, SEARCHTEX_HEIGHT);
-    Blink::PixelInfo pixelInfo(1, kBlinkDataFloat);
+    TraceScope scope("create_search_texture");
+
+    Blink::Rect rect(0, 0, SEARCHTABLE_WIDTH, SEARCHTABLE_HEIGHT);
+    Blink::PixelInfo pixelInfo(SEARCHTABLE_CHANNELS, kBlinkDataFloat);
     Blink::ImageInfo imageInfo(rect, pixelInfo);
 
     Blink::Image image = Blink::Image(imageInfo, device);
     Blink::BufferDesc bufferDesc(
         sizeof(float),
-        sizeof(float) * SEARCHTEX_WIDTH,
+        sizeof(float) * SEARCHTABLE_WIDTH,
         sizeof(float)
     );
-    image.copyFromBuffer(_search_texture.data(), bufferDesc);
+    image.copyFromBuffer(searchTable, bufferDesc);
     return image;
 }
 
 Blink::Image Smaa::create_area_texture(Blink::ComputeDevice device) {
-    Blink::Rect rect(0, 0, AREATEX_WIDTH, AREATEX_HEIGHT);
-    Blink::PixelInfo pixelInfo(2, kBlinkDataFloat);
+    TraceScope scope("create_area_texture");
+
+    Blink::Rect rect(0, 0, AREATABLE_WIDTH, AREATABLE_HEIGHT);
+    Blink::PixelInfo pixelInfo(AREATABLE_CHANNELS, kBlinkDataFloat);
     Blink::ImageInfo imageInfo(rect, pixelInfo);
 
     Blink::Image image = Blink::Image(imageInfo, device);
     Blink::BufferDesc bufferDesc(
-        sizeof(float) * 2,
-        sizeof(float) * AREATEX_WIDTH,
+        sizeof(float) * AREATABLE_CHANNELS,
+        sizeof(float) * AREATABLE_CHANNELS * AREATABLE_WIDTH,
         sizeof(float)
     );
-    image.copyFromBuffer(_area_texture.data(), bufferDesc);
+    image.copyFromBuffer(areaTable, bufferDesc);
     return image;
 }
 
-void Smaa::convert_texture(
-    const unsigned char* source, std::vector<float>& destination,
-    int width, int height, int channelNumber
-) {
-    const int size = width * height * channelNumber;
-    destination.reserve(size);
+void Smaa::fetch_textures(
+    Blink::ComputeDevice device,
+    Blink::Image& search_tex,
+    Blink::Image& area_tex
+)
+{
+    std::lock_guard<std::mutex> lock(_textures_mutex);
+
+    std::map<std::string, Textures>::iterator it = _textures.find(
+        device.name()
+    );
+
+    if (it == _textures.end()) {
+        Textures textures;
+        textures.search = create_search_texture(device);
+        textures.area = create_area_texture(device);
+        it = _textures.insert(std::make_pair(device.name(), textures)).first;
+    }
+
+    search_tex = it->second.search;
+    area_tex = it->second.area;
+}
+
+void Smaa::start_warm_up(Blink::ComputeDevice device, int components)
+{
+    const std::string key = warm_up_key(device, components);
+
+    std::lock_guard<std::mutex> lock(_warm_ups_mutex);
+    if (_warm_ups.find(key) != _warm_ups.end()) {
+        return;
+    }
+
+    try {
+        _warm_ups[key] = std::async(
+            std::launch::async, warm_up, device, components
+        ).share();
+    }
+    catch (std::system_error&) {
+        // Without thread available, kernels are compiled on first render.
+    }
+}
+
+void Smaa::wait_warm_up(Blink::ComputeDevice device, int components)
+{
+    std::shared_future<void> pending;
+    {
+        std::lock_guard<std::mutex> lock(_warm_ups_mutex);
+        std::map<std::string, std::shared_future<void>>::iterator it = (
+            _warm_ups.find(warm_up_key(device, components))
+        );
+        if (it == _warm_ups.end()) {
+            return;
+        }
+        pending = it->second;
+    }
+
+    pending.wait();
+}
+
+void Smaa::warm_up(Blink::ComputeDevice device, int components)
+{
+    TraceScope scope("warm_up");
 
-    for (int index = 0; index < size; index++) {
-        destination.push_back((float) source[index]);
+    try {
+        Blink::ComputeDeviceBinder binder(device);
+
+        Blink::Image search_tex;
+        Blink::Image area_tex;
+        fetch_textures(device, search_tex, area_tex);
+
+        // Kernels are compiled for the types of the images they are
+        // constructed with, so small images of the same types as the ones
+        // rendered are enough.
+        const DD::Image::Box box(0, 0, 8, 8);
+        Blink::Image input = create_intermediate_image(
+            device, box, components
+        );
+        Blink::Image luma_tex = create_intermediate_image(device, box, 1);
+        Blink::Image edges_tex = create_intermediate_image(device, box);
+        Blink::Image blend_tex = create_intermediate_image(device, box);
+        Blink::Image output = create_intermediate_image(
+            device, box, components
+        );
+
+        std::vector<Blink::Image> luma_images;
+        luma_images.push_back(input);
+        luma_images.push_back(luma_tex);
+        Blink::Kernel luma_kernel(
+            Blink::ProgramSource(SMAALuma), device, luma_images,
+            kBlinkCodegenDefault
+        );
+
+        std::vector<Blink::Image> edges_images;
+        edges_images.push_back(luma_tex);
+        edges_images.push_back(edges_tex);
+        Blink::Kernel edges_kernel(
+            Blink::ProgramSource(SMAALumaEdges), device, edges_images,
+            kBlinkCodegenDefault
+        );
+
+        std::vector<Blink::Image> blend_images;
+        blend_images.push_back(edges_tex);
+        blend_images.push_back(area_tex);
+        blend_images.push_back(search_tex);
+        blend_images.push_back(blend_tex);
+        Blink::Kernel blend_kernel(
+            Blink::ProgramSource(SMAABlend), device, blend_images,
+            kBlinkCodegenDefault
+        );
+
+        std::vector<Blink::Image> neighborhood_images;
+        neighborhood_images.push_back(input);
+        neighborhood_images.push_back(blend_tex);
+        neighborhood_images.push_back(output);
+        Blink::Kernel neighborhood_kernel(
+            Blink::ProgramSource(SMAANeighborhood), device,
+            neighborhood_images, kBlinkCodegenDefault
+        );
+    }
+    catch (Blink::Exception&) {
+        // Errors are reported by the render, which compiles kernels again.
     }
 }
 
@@ -8,13 +8,22 @@
 #ifndef SMAA_NUKE_H
 #define SMAA_NUKE_H
 
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+
 #include "DDImage/PlanarIop.h"
 #include "DDImage/Knobs.h"
 #include "DDImage/NukeWrapper.h"
 #include "DDImage/Blink.h"
+#include "DDImage/MetaData.h"
 
 #include "Blink/Blink.h"
 
+#include "BatchPipeline.h"
+#include "MemoryCounter.h"
+
 
 namespace Nuke {
 
@@ -42,11 +51,61 @@ protected:
         int count, DD::Image::RequestOutput &data
     ) const;
 
+    // Add peak memory of the frame requested and its stripes to metadata of
+    // input, as recorded when the frame was last rendered, or 0 before.
+    const DD::Image::MetaData::Bundle& _fetchMetaData(const char* key);
+
     void renderStripe(DD::Image::ImagePlane &output_plane);
 
-    void run_edges_detection(
+    // Render stripe, accounting allocations on memory.
+    void render_stripe(
+        DD::Image::ImagePlane &output_plane, MemoryCounter& memory
+    );
+
+    // Apply SMAA on plane holding processed channels only.
+    void process_plane(
+        DD::Image::ImagePlane &output_plane, MemoryCounter& memory
+    );
+
+    // Apply SMAA on CPU without Blink, from input plane to output plane
+    // holding the same bounds and channels.
+    void run_native_pipeline(
+        const DD::Image::ImagePlane& input_plane,
+        DD::Image::ImagePlane& output_plane,
+        MemoryCounter& memory
+    );
+
+    // Restart memory peaks when a new frame is rendered.
+    void begin_frame_memory(double frame);
+
+    // Record peak memory of stripe and of its frame.
+    void end_stripe_memory(
+        const DD::Image::ImagePlane& output_plane, const MemoryCounter& memory
+    );
+
+    // Copy channels which are present in both planes.
+    static void copy_channels(
+        const DD::Image::ImagePlane& source,
+        DD::Image::ImagePlane& destination,
+        const DD::Image::ChannelSet& channels
+    );
+
+    // Create float image for intermediate results, RGBA by default.
+    static Blink::Image create_intermediate_image(
+        Blink::ComputeDevice device, const DD::Image::Box& box,
+        int components = 4
+    );
+
+    // Compute luma of input once into single channel image.
+    void run_luma(
         Blink::ComputeDevice device,
         const Blink::Image& input,
+        const Blink::Image& luma_tex
+    );
+
+    void run_edges_detection(
+        Blink::ComputeDevice device,
+        const Blink::Image& luma_tex,
         const Blink::Image& edges_tex
     );
 
@@ -63,25 +122,76 @@ protected:
         const Blink::Image& output
     );
 
-    Blink::Image create_search_texture(Blink::ComputeDevice device);
-    Blink::Image create_area_texture(Blink::ComputeDevice device);
+    static Blink::Image create_search_texture(Blink::ComputeDevice device);
+    static Blink::Image create_area_texture(Blink::ComputeDevice device);
 
-    // Convert texture from unsigned char to float array.
-    static void convert_texture(
-        const unsigned char* source, std::vector<float>& destination,
-        int width, int height, int channelNumber
+    // Fetch search and area textures for device, which are only created on
+    // first use and shared by all nodes.
+    static void fetch_textures(
+        Blink::ComputeDevice device,
+        Blink::Image& search_tex,
+        Blink::Image& area_tex
     );
 
+    // Start warming up device for input with components in background,
+    // unless already started by any node, so that the first render finds
+    // kernels compiled and textures created.
+    static void start_warm_up(Blink::ComputeDevice device, int components);
+
+    // Wait until warm-up of device for input with components is done, if
+    // started.
+    static void wait_warm_up(Blink::ComputeDevice device, int components);
+
+    // Compile Blink kernels on device for input with components, and create
+    // textures of device.
+    static void warm_up(Blink::ComputeDevice device, int components);
+
 private:
+    struct Textures
+    {
+        Blink::Image search;
+        Blink::Image area;
+    };
+
+    // Textures per compute device name.
+    static std::map<std::string, Textures> _textures;
+    static std::mutex _textures_mutex;
+
+    // Warm-ups per compute device name and number of components.
+    static std::map<std::string, std::shared_future<void>> _warm_ups;
+    static std::mutex _warm_ups_mutex;
+
     Blink::ComputeDevice _gpu_device;
     bool _use_gpu_if_available;
+    bool _use_native_cpu;
+    bool _alpha_passthrough;
+    int _weight_precision;
+    bool _trace;
 
+    DD::Image::ChannelSet _processed_channels;
+
+    Blink::ProgramSource _luma_program;
     Blink::ProgramSource _edges_program;
     Blink::ProgramSource _blend_program;
     Blink::ProgramSource _neighborhood_program;
 
-    std::vector<float> _search_texture;
-    std::vector<float> _area_texture;
+    BatchPipeline _native_pipeline;
+
+    struct MemoryPeaks
+    {
+        long long frame;
+        long long stripe;
+    };
+
+    // Bytes held by stripes of the frame being rendered, and peaks of each
+    // frame rendered and of its stripes.
+    MemoryCounter _frame_memory;
+    std::map<double, MemoryPeaks> _memory_peaks;
+    double _memory_frame;
+    bool _memory_frame_started;
+    std::mutex _memory_mutex;
+
+    DD::Image::MetaData::Bundle _meta_data;
 };
 
 } // namespace Nuke
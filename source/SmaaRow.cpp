@@ -0,0 +1,184 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "DDImage/Iop.h"
+#include "DDImage/Row.h"
+#include "DDImage/Knobs.h"
+#include "DDImage/Channel.h"
+
+#include "SmaaRow.h"
+
+static const char* const CLASS = "SmaaRow";
+static const char* const HELP = (
+    "Subpixel Morphological Anti-Aliasing, computed row by row on CPU "
+    "to bound memory on large images."
+);
+
+static DD::Image::Iop* build(Node *node) {
+    return new Nuke::SmaaRow(node);
+}
+const DD::Image::Iop::Description Nuke::SmaaRow::description(
+    CLASS, "Filter/SmaaRow", build
+);
+
+
+namespace Nuke {
+
+const char* SmaaRow::Class() const { return CLASS; }
+const char* SmaaRow::node_help() const { return HELP; }
+
+SmaaRow::SmaaRow(Node* node)
+    : DD::Image::Iop(node)
+    , _band_height(RowPipeline::default_band_height())
+    , _max_bands(RowPipeline::default_max_bands())
+    , _processed_channels(DD::Image::Mask_RGBA)
+{
+}
+
+void SmaaRow::knobs(DD::Image::Knob_Closure &f)
+{
+    Int_knob(f, &_band_height, "band_height", "Band height");
+    Tooltip(
+        f, "Number of rows computed at once, rounded up to 64. Each band is "
+        "computed along with the rows searches depend on above and below "
+        "it, so taller bands spend less time on these rows but hold more "
+        "memory."
+    );
+    Int_knob(f, &_max_bands, "cached_bands", "Cached bands");
+    Tooltip(
+        f, "Number of bands kept for threads reading rows, so that cached "
+        "rows are bounded by this number times the band height, whatever "
+        "the number of threads. Raise it when more threads read rows far "
+        "apart from each other."
+    );
+}
+
+void SmaaRow::_validate(bool)
+{
+    // Copy bbox channels etc from input0, which will validate it.
+    copy_info();
+
+    // Only process alpha channel if input provides it.
+    _processed_channels = DD::Image::Mask_RGB;
+    if (input0().info().channels().contains(DD::Image::Chan_Alpha)) {
+        _processed_channels += DD::Image::Mask_Alpha;
+    }
+    set_out_channels(_processed_channels);
+
+    // Turn alpha channel on.
+    info_.turn_on(DD::Image::Mask_RGBA);
+
+    _pipeline.set_band_height(_band_height);
+    _pipeline.set_max_bands(_max_bands);
+    _pipeline.resize(info_.w(), info_.h(), _processed_channels.size());
+}
+
+void SmaaRow::_request(
+    int x, int y, int r, int t, DD::Image::ChannelMask channels, int count
+)
+{
+    // Bands covering the rows requested are computed over the whole width,
+    // along with rows within the row radius.
+    const int margin = (
+        NativePipeline::row_radius() + _pipeline.band_height()
+    );
+
+    DD::Image::ChannelSet requested = channels;
+    requested += _processed_channels;
+
+    input0().request(
+        std::min(x, info_.x()), std::max(y - margin, info_.y()),
+        std::max(r, info_.r()), std::min(t + margin, info_.t()),
+        requested, count
+    );
+}
+
+void SmaaRow::_open()
+{
+    _pipeline.clear();
+}
+
+void SmaaRow::_close()
+{
+    _pipeline.release();
+}
+
+void SmaaRow::engine(
+    int y, int x, int r, DD::Image::ChannelMask channels,
+    DD::Image::Row& row
+)
+{
+    DD::Image::ChannelSet processed = channels;
+    processed &= _processed_channels;
+
+    // Rows and pixels outside of the bounding box, and channels which
+    // cannot be affected, are copied from input.
+    const bool inside_rows = y >= info_.y() && y < info_.t();
+    const bool inside = inside_rows && x >= info_.x() && r <= info_.r();
+
+    DD::Image::ChannelSet copied = channels;
+    if (inside) {
+        copied -= processed;
+    }
+
+    if (!copied.empty()) {
+        row.get(input0(), y, x, r, copied);
+    }
+
+    if (processed.empty() || !inside_rows || aborted()) {
+        return;
+    }
+
+    const int components = _processed_channels.size();
+    std::vector<float> values((size_t) info_.w() * components);
+
+    _pipeline.read_row(
+        y - info_.y(),
+        [this](int input_y, float* input_row) {
+            read_input_row(input_y, input_row);
+        },
+        &values[0]
+    );
+
+    const int x0 = std::max(x, info_.x());
+    const int x1 = std::min(r, info_.r());
+
+    foreach(channel, processed) {
+        const int component = DD::Image::colourIndex(channel);
+        float* output = row.writable(channel);
+
+        for (int pixel_x = x0; pixel_x < x1; pixel_x++) {
+            output[pixel_x] = values[
+                (pixel_x - info_.x()) * components + component
+            ];
+        }
+    }
+}
+
+void SmaaRow::read_input_row(int y, float* row)
+{
+    const int x = info_.x();
+    const int r = info_.r();
+    const int components = _processed_channels.size();
+
+    DD::Image::Row input(x, r);
+    input.get(input0(), y + info_.y(), x, r, _processed_channels);
+
+    foreach(channel, _processed_channels) {
+        const int component = DD::Image::colourIndex(channel);
+        const float* values = input[channel];
+
+        for (int pixel_x = x; pixel_x < r; pixel_x++) {
+            row[(pixel_x - x) * components + component] = values[pixel_x];
+        }
+    }
+}
+
+} // namespace Nuke
@@ -0,0 +1,76 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_ROW_H
+#define SMAA_NUKE_ROW_H
+
+#include "DDImage/Iop.h"
+#include "DDImage/Row.h"
+#include "DDImage/Knobs.h"
+
+#include "RowPipeline.h"
+
+
+namespace Nuke {
+
+/**
+ * SMAA computed by the native CPU pipeline as a row based operator.
+ *
+ * Rows are produced on demand from bands of rows cached by the pipeline,
+ * so that whole planes never need to be held and memory only grows with
+ * the width of the image.
+ */
+class SmaaRow : public DD::Image::Iop
+{
+public:
+    SmaaRow(Node *node);
+    virtual ~SmaaRow() {}
+
+    const char *Class() const;
+    const char *node_help() const;
+
+    static const Iop::Description description;
+
+    int maximum_inputs() const { return 1; }
+    int minimum_inputs() const { return 1; }
+
+protected:
+    virtual void knobs(DD::Image::Knob_Callback f);
+    void _validate(bool);
+
+    void _request(
+        int x, int y, int r, int t, DD::Image::ChannelMask channels,
+        int count
+    );
+
+    // Release cached bands, as input may have changed.
+    void _open();
+
+    // Release cached bands and workspaces once rows are no longer needed.
+    void _close();
+
+    void engine(
+        int y, int x, int r, DD::Image::ChannelMask channels,
+        DD::Image::Row& row
+    );
+
+    // Fill row at y, relative to the bottom of the bounding box, with
+    // processed channels of input interleaved.
+    void read_input_row(int y, float* row);
+
+private:
+    int _band_height;
+    int _max_bands;
+
+    DD::Image::ChannelSet _processed_channels;
+
+    RowPipeline _pipeline;
+};
+
+} // namespace Nuke
+
+#endif
@@ -0,0 +1,201 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdlib>
+#include <string>
+
+#include "ThreadPool.h"
+#include "Topology.h"
+
+
+namespace {
+
+bool pin_threads()
+{
+    const char* value = std::getenv("SMAA_PIN_THREADS");
+    return value && std::string(value) == "1";
+}
+
+} // namespace
+
+
+namespace Nuke {
+
+ThreadPool::ThreadPool(int threads, bool pinned)
+    : _pinned(false)
+    , _task(0)
+    , _count(0)
+    , _max_workers(0)
+    , _schedule(DYNAMIC)
+    , _next(0)
+    , _failed(false)
+    , _active(0)
+    , _generation(0)
+    , _stop(false)
+{
+    if (threads <= 0) {
+        threads = (int) std::thread::hardware_concurrency();
+    }
+
+    std::vector<int> cpus;
+    if (pinned) {
+        cpus = cpu_order();
+        _pinned = !cpus.empty();
+    }
+
+    // Worker 0 is the calling thread unless pinned.
+    for (int worker = _pinned ? 0 : 1; worker < threads; worker++) {
+        const int cpu = _pinned ? cpus[worker % cpus.size()] : -1;
+        _threads.push_back(std::thread(&ThreadPool::work, this, worker, cpu));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _start.notify_all();
+
+    for (size_t index = 0; index < _threads.size(); index++) {
+        _threads[index].join();
+    }
+}
+
+void ThreadPool::run(
+    int count, const Task& task, int max_workers, Schedule schedule
+)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    if (max_workers <= 0 || max_workers > size()) {
+        max_workers = size();
+    }
+
+    std::lock_guard<std::mutex> run_lock(_run_mutex);
+
+    // Avoid waking up threads for a single task, unless it must run on a
+    // pinned thread.
+    if (!_pinned && (max_workers == 1 || count == 1)) {
+        for (int index = 0; index < count; index++) {
+            task(index, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task = &task;
+        _count = count;
+        _max_workers = max_workers;
+        _schedule = schedule;
+        _next = 0;
+        _failed = false;
+        _exception = std::exception_ptr();
+        _active = (int) _threads.size();
+        _generation++;
+    }
+    _start.notify_all();
+
+    if (!_pinned) {
+        execute(0);
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_active > 0) {
+        _done.wait(lock);
+    }
+    _task = 0;
+
+    if (_exception) {
+        std::exception_ptr exception = _exception;
+        _exception = std::exception_ptr();
+        std::rethrow_exception(exception);
+    }
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool(0, pin_threads());
+    return pool;
+}
+
+void ThreadPool::work(int worker, int cpu)
+{
+    if (cpu >= 0) {
+        pin_current_thread(cpu);
+    }
+
+    unsigned int generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (!_stop && _generation == generation) {
+                _start.wait(lock);
+            }
+
+            if (_stop) {
+                return;
+            }
+
+            generation = _generation;
+        }
+
+        // Workers beyond limit skip the run.
+        if (worker < _max_workers) {
+            execute(worker);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_active == 0) {
+            _done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::execute(int worker)
+{
+    if (_schedule == STATIC) {
+        const long long count = _count;
+        const int start = (int) (count * worker / _max_workers);
+        const int end = (int) (count * (worker + 1) / _max_workers);
+
+        for (int index = start; index < end && !_failed; index++) {
+            execute_task(index, worker);
+        }
+        return;
+    }
+
+    while (!_failed) {
+        const int index = _next++;
+        if (index >= _count) {
+            return;
+        }
+
+        execute_task(index, worker);
+    }
+}
+
+void ThreadPool::execute_task(int index, int worker)
+{
+    try {
+        (*_task)(index, worker);
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_exception) {
+            _exception = std::current_exception();
+        }
+        _failed = true;
+    }
+}
+
+} // namespace Nuke
@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_THREAD_POOL_H
+#define SMAA_NUKE_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace Nuke {
+
+/**
+ * Fixed set of threads running indexed tasks.
+ *
+ * The calling thread takes part in each run as worker 0, so that a pool of
+ * size one runs everything inline.
+ *
+ * Workers can instead all be pinned to logical CPUs ordered by NUMA node,
+ * so that with a static schedule, consecutive indices stay on the same
+ * node. The calling thread then only waits for them, as it could run on
+ * any node.
+ */
+class ThreadPool
+{
+public:
+    typedef std::function<void(int index, int worker)> Task;
+
+    enum Schedule
+    {
+        // Indices are taken by whichever worker is available.
+        DYNAMIC,
+
+        // Indices are split into contiguous ranges, one per worker, so that
+        // runs with the same count assign each index to the same worker.
+        STATIC
+    };
+
+    // Create pool of threads, including the calling thread unless pinned.
+    // All hardware threads are used when zero. When pinned, each thread is
+    // created and restricted to one logical CPU.
+    explicit ThreadPool(int threads = 0, bool pinned = false);
+    ~ThreadPool();
+
+    int size() const { return (int) _threads.size() + (_pinned ? 0 : 1); }
+
+    bool pinned() const { return _pinned; }
+
+    // Call task for each index in [0, count) and wait for all of them,
+    // using at most a number of workers when not zero. Concurrent runs are
+    // executed one after the other. When tasks throw, remaining indices
+    // are skipped and the first exception is thrown again on the calling
+    // thread once all workers are done.
+    void run(
+        int count, const Task& task, int max_workers = 0,
+        Schedule schedule = DYNAMIC
+    );
+
+    // Pool shared by all pipelines of the process, pinned when the
+    // SMAA_PIN_THREADS environment variable is set to 1.
+    static ThreadPool& shared();
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void work(int worker, int cpu);
+    void execute(int worker);
+
+    // Run task at index, recording its exception if it throws.
+    void execute_task(int index, int worker);
+
+    std::vector<std::thread> _threads;
+    bool _pinned;
+
+    std::mutex _run_mutex;
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+
+    const Task* _task;
+    int _count;
+    int _max_workers;
+    Schedule _schedule;
+    std::atomic<int> _next;
+    std::atomic<bool> _failed;
+    std::exception_ptr _exception;
+    int _active;
+    unsigned int _generation;
+    bool _stop;
+};
+
+} // namespace Nuke
+
+#endif
@@ -0,0 +1,170 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "Topology.h"
+
+
+namespace {
+
+#if defined(__linux__)
+
+// Read first line of file, or empty string when it cannot be read.
+std::string read_line(const std::string& path)
+{
+    std::ifstream stream(path.c_str());
+    std::string line;
+    std::getline(stream, line);
+    return line;
+}
+
+// Return NUMA nodes of the host, sorted.
+std::vector<int> numa_nodes()
+{
+    std::vector<int> nodes;
+
+    DIR* directory = opendir("/sys/devices/system/node");
+    if (!directory) {
+        return nodes;
+    }
+
+    while (struct dirent* entry = readdir(directory)) {
+        const std::string name(entry->d_name);
+        if (
+            name.size() > 4 && name.compare(0, 4, "node") == 0
+            && name.find_first_not_of("0123456789", 4) == std::string::npos
+        ) {
+            nodes.push_back(std::atoi(name.c_str() + 4));
+        }
+    }
+
+    closedir(directory);
+
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+#endif
+
+} // namespace
+
+
+namespace Nuke {
+
+std::vector<int> parse_cpu_list(const std::string& list)
+{
+    std::vector<int> cpus;
+
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+
+        const int first = std::atoi(range.c_str());
+        const size_t separator = range.find('-');
+        const int last = (
+            separator == std::string::npos
+            ? first : std::atoi(range.c_str() + separator + 1)
+        );
+
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+std::vector<int> cpu_order()
+{
+    std::vector<int> order;
+
+#if defined(__linux__)
+    std::vector<std::vector<int> > node_cpus;
+
+    const std::vector<int> nodes = numa_nodes();
+    for (size_t index = 0; index < nodes.size(); index++) {
+        std::stringstream path;
+        path << "/sys/devices/system/node/node" << nodes[index] << "/cpulist";
+        node_cpus.push_back(parse_cpu_list(read_line(path.str())));
+    }
+
+    // Without NUMA support, consider all online CPUs as one node.
+    if (node_cpus.empty()) {
+        node_cpus.push_back(
+            parse_cpu_list(read_line("/sys/devices/system/cpu/online"))
+        );
+    }
+
+    for (size_t node = 0; node < node_cpus.size(); node++) {
+        const std::vector<int>& cpus = node_cpus[node];
+
+        for (size_t index = 0; index < cpus.size(); index++) {
+            const int cpu = cpus[index];
+            if (std::find(order.begin(), order.end(), cpu) != order.end()) {
+                continue;
+            }
+
+            std::stringstream path;
+            path << "/sys/devices/system/cpu/cpu" << cpu
+                 << "/topology/thread_siblings_list";
+
+            std::vector<int> siblings = parse_cpu_list(read_line(path.str()));
+            if (siblings.empty()) {
+                siblings.push_back(cpu);
+            }
+
+            // Siblings share the core, and therefore the node.
+            for (size_t sibling = 0; sibling < siblings.size(); sibling++) {
+                const int sibling_cpu = siblings[sibling];
+                if (
+                    std::find(cpus.begin(), cpus.end(), sibling_cpu)
+                    != cpus.end()
+                    && std::find(order.begin(), order.end(), sibling_cpu)
+                    == order.end()
+                ) {
+                    order.push_back(sibling_cpu);
+                }
+            }
+        }
+    }
+#endif
+
+    return order;
+}
+
+bool pin_current_thread(int cpu)
+{
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void) cpu;
+    return false;
+#endif
+}
+
+} // namespace Nuke
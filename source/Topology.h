@@ -0,0 +1,30 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_TOPOLOGY_H
+#define SMAA_NUKE_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+
+namespace Nuke {
+
+// Parse CPU list such as "0-3,8,10-11" into logical CPU indices.
+std::vector<int> parse_cpu_list(const std::string& list);
+
+// Return logical CPUs grouped by NUMA node, and by physical core within
+// each node so that SMT siblings are adjacent. Empty when the topology
+// cannot be read.
+std::vector<int> cpu_order();
+
+// Restrict calling thread to logical CPU. Return whether it succeeded.
+bool pin_current_thread(int cpu);
+
+} // namespace Nuke
+
+#endif
@@ -0,0 +1,351 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "Trace.h"
+
+
+namespace {
+
+// Number of events per chunk of thread buffers.
+const int CHUNK_SIZE = 4096;
+
+// Number of full chunks which are written to the trace file at once.
+const size_t FLUSH_CHUNKS = 16;
+
+struct TraceEvent
+{
+    const char* name;
+    int64_t start;
+    int64_t end;
+};
+
+/**
+ * Fixed array of events recorded by a thread.
+ *
+ * Only the owning thread appends events, and publishes them by updating
+ * size, so that the writer can read chunks while events are recorded. Full
+ * chunks are handed to the writer, which recycles them once written.
+ */
+struct TraceChunk
+{
+    TraceChunk() : size(0), written(0), thread_id(0) {}
+
+    TraceEvent events[CHUNK_SIZE];
+    std::atomic<int> size;
+
+    // Number of events already written, only accessed by the writer.
+    int written;
+
+    int thread_id;
+};
+
+struct ThreadTrace
+{
+    explicit ThreadTrace(int id) : id(id), chunk(0) {}
+
+    int id;
+
+    // Chunk events are recorded into, only replaced by the owning thread.
+    std::atomic<TraceChunk*> chunk;
+};
+
+/**
+ * Buffers of all threads which recorded events, written incrementally to
+ * the trace file as chunks fill up, after each stripe and when the process
+ * exits.
+ *
+ * Events are written as a JSON array, which trace viewers still open when
+ * the process is killed before closing it. Thread buffers are never
+ * released, as threads of the host application may still record events
+ * while the process exits.
+ */
+class TraceRegistry
+{
+public:
+    TraceRegistry() : file(0), first(true) {}
+
+    ~TraceRegistry()
+    {
+        if (Nuke::trace_enabled()) {
+            Nuke::detail::trace_enabled.store(false);
+            flush(true);
+        }
+
+        std::lock_guard<std::mutex> lock(file_mutex);
+        if (file) {
+            std::fputs("\n]\n", file);
+            std::fclose(file);
+        }
+    }
+
+    ThreadTrace* add_thread()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.push_back(new ThreadTrace((int) threads.size() + 1));
+        threads.back()->chunk.store(
+            take_chunk(threads.back()->id), std::memory_order_release
+        );
+        return threads.back();
+    }
+
+    // Hand full chunk of trace to the writer, and return the chunk to record
+    // next events into. Full chunks are written once enough of them are
+    // pending, unless another thread is already writing.
+    TraceChunk* exchange_chunk(ThreadTrace& trace, TraceChunk* full)
+    {
+        TraceChunk* next;
+        bool pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            next = take_chunk(trace.id);
+
+            // Replace chunk of thread before handing it to the writer, so
+            // that it is never written both as full and as current chunk.
+            trace.chunk.store(next, std::memory_order_release);
+            full_chunks.push_back(full);
+            pending = full_chunks.size() >= FLUSH_CHUNKS;
+        }
+
+        if (pending) {
+            flush(false);
+        }
+
+        return next;
+    }
+
+    // Write events which were not written yet. When wait is false, return
+    // immediately if another thread is already writing.
+    bool flush(bool wait)
+    {
+        std::unique_lock<std::mutex> file_lock(file_mutex, std::defer_lock);
+        if (wait) {
+            file_lock.lock();
+        }
+        else if (!file_lock.try_lock()) {
+            return true;
+        }
+
+        if (!file) {
+            file = std::fopen(Nuke::trace_file_path().c_str(), "w");
+            if (!file) {
+                return false;
+            }
+            std::fputc('[', file);
+        }
+
+        std::vector<TraceChunk*> chunks;
+        std::vector<ThreadTrace*> current_threads;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            chunks.swap(full_chunks);
+            current_threads = threads;
+        }
+
+        for (size_t index = 0; index < chunks.size(); index++) {
+            write_chunk(chunks[index]);
+            chunks[index]->size.store(0, std::memory_order_relaxed);
+            chunks[index]->written = 0;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            free_chunks.insert(free_chunks.end(), chunks.begin(), chunks.end());
+        }
+
+        // Chunks being recorded into are written up to the last event
+        // published, and only recycled by this function once full.
+        for (size_t index = 0; index < current_threads.size(); index++) {
+            write_chunk(
+                current_threads[index]->chunk.load(std::memory_order_acquire)
+            );
+        }
+
+        return std::fflush(file) == 0;
+    }
+
+    std::mutex mutex;
+    std::vector<ThreadTrace*> threads;
+    std::vector<TraceChunk*> full_chunks;
+    std::vector<TraceChunk*> free_chunks;
+
+private:
+    // Return a recycled or new chunk for thread. Mutex must be held.
+    TraceChunk* take_chunk(int thread_id)
+    {
+        TraceChunk* chunk;
+        if (free_chunks.empty()) {
+            chunk = new TraceChunk();
+        }
+        else {
+            chunk = free_chunks.back();
+            free_chunks.pop_back();
+        }
+
+        chunk->thread_id = thread_id;
+        return chunk;
+    }
+
+    // Write events of chunk which were not written yet. File mutex must be
+    // held.
+    void write_chunk(TraceChunk* chunk);
+
+    std::mutex file_mutex;
+    std::FILE* file;
+    bool first;
+};
+
+TraceRegistry& registry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+ThreadTrace& thread_trace()
+{
+    static thread_local ThreadTrace* trace = 0;
+    if (!trace) {
+        trace = registry().add_thread();
+    }
+    return *trace;
+}
+
+const std::chrono::steady_clock::time_point EPOCH = (
+    std::chrono::steady_clock::now()
+);
+
+bool trace_requested()
+{
+    const char* path = std::getenv("SMAA_TRACE");
+    return path && path[0] != 0;
+}
+
+int process_id()
+{
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return (int) getpid();
+#endif
+}
+
+// Write name as JSON string.
+void write_name(std::FILE* file, const char* name)
+{
+    std::fputc('"', file);
+    for (const char* character = name; *character; character++) {
+        if (*character == '"' || *character == '\\') {
+            std::fputc('\\', file);
+        }
+        std::fputc(*character, file);
+    }
+    std::fputc('"', file);
+}
+
+void TraceRegistry::write_chunk(TraceChunk* chunk)
+{
+    const int size = chunk->size.load(std::memory_order_acquire);
+    const int pid = process_id();
+
+    for (int index = chunk->written; index < size; index++) {
+        const TraceEvent& event = chunk->events[index];
+
+        // Complete events, with timestamps in microseconds.
+        std::fputs(first ? "\n{\"name\":" : ",\n{\"name\":", file);
+        write_name(file, event.name);
+        std::fprintf(
+            file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":%d,\"tid\":%d}",
+            event.start / 1000.0, (event.end - event.start) / 1000.0,
+            pid, chunk->thread_id
+        );
+        first = false;
+    }
+
+    chunk->written = size;
+}
+
+} // namespace
+
+
+namespace Nuke {
+
+namespace detail {
+
+std::atomic<bool> trace_enabled(trace_requested());
+
+int64_t trace_clock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - EPOCH
+    ).count();
+}
+
+void record_trace_event(const char* name, int64_t start, int64_t end)
+{
+    ThreadTrace& trace = thread_trace();
+
+    TraceChunk* chunk = trace.chunk.load(std::memory_order_relaxed);
+    int size = chunk->size.load(std::memory_order_relaxed);
+
+    if (size == CHUNK_SIZE) {
+        chunk = registry().exchange_chunk(trace, chunk);
+        size = 0;
+    }
+
+    TraceEvent& event = chunk->events[size];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+
+    chunk->size.store(size + 1, std::memory_order_release);
+}
+
+} // namespace detail
+
+void enable_trace()
+{
+    // Create registry first, so that it is destroyed after threads stop
+    // recording events.
+    registry();
+    detail::trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+std::string trace_file_path()
+{
+    const char* path = std::getenv("SMAA_TRACE");
+    if (path && path[0] != 0) {
+        return std::string(path);
+    }
+
+    std::ostringstream stream;
+    stream << "smaa-trace-" << process_id() << ".json";
+    return stream.str();
+}
+
+bool flush_trace()
+{
+    if (!trace_enabled()) {
+        return true;
+    }
+
+    return registry().flush(false);
+}
+
+} // namespace Nuke
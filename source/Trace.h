@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2019, Jeremy Retailleau
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef SMAA_NUKE_TRACE_H
+#define SMAA_NUKE_TRACE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+
+namespace Nuke {
+
+namespace detail {
+
+extern std::atomic<bool> trace_enabled;
+
+// Return current time in nanoseconds, relative to the start of the process.
+int64_t trace_clock();
+
+// Append event to buffer of calling thread.
+void record_trace_event(const char* name, int64_t start, int64_t end);
+
+} // namespace detail
+
+// Return whether events are recorded. Tracing is enabled when the
+// SMAA_TRACE environment variable holds the path of the trace file.
+inline bool trace_enabled()
+{
+    return detail::trace_enabled.load(std::memory_order_relaxed);
+}
+
+// Start recording events, which are written to the trace file as buffers
+// fill up, when flushed and when the process exits.
+void enable_trace();
+
+// Return path of the trace file, from the SMAA_TRACE environment variable,
+// or smaa-trace-<pid>.json in the current directory.
+std::string trace_file_path();
+
+// Append events recorded since last flush to the trace file as Chrome trace
+// JSON, which can be opened with Perfetto or chrome://tracing. Return
+// immediately if another thread is already writing them. Return whether it
+// succeeded.
+bool flush_trace();
+
+/**
+ * Record duration of the enclosing scope as a trace event.
+ *
+ * Events are appended to a buffer owned by the calling thread, so that
+ * recording never takes a lock. Name must outlive the process, such as a
+ * string literal.
+ */
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name)
+        : _name(trace_enabled() ? name : 0)
+        , _start(_name ? detail::trace_clock() : 0)
+    {}
+
+    ~TraceScope() { stop(); }
+
+    // End event before the end of the scope.
+    void stop()
+    {
+        if (_name) {
+            detail::record_trace_event(_name, _start, detail::trace_clock());
+            _name = 0;
+        }
+    }
+
+private:
+    TraceScope(const TraceScope&);
+    TraceScope& operator=(const TraceScope&);
+
+    const char* _name;
+    int64_t _start;
+};
+
+} // namespace Nuke
+
+#endif